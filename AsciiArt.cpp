@@ -0,0 +1,87 @@
+/*
+    File: AsciiArt.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <AsciiArt.h>
+
+// Qt
+#include <QRgb>
+
+// C++
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+//------------------------------------------------------------------
+std::vector<unsigned int> AsciiArt::cellAverages(const QImage &image, const QSize &cell)
+{
+  const int textWidth  = cell.width();
+  const int textHeight = cell.height();
+  if(textWidth <= 0 || textHeight <= 0) return {};
+
+  const int horizontalBlocks = image.width() / textWidth;
+  const int verticalBlocks = image.height() / textHeight;
+
+  // summed-area table of the luma of the area covered by the cells, with a zero first row and
+  // column. The sums are modulo 2^32 but the difference of the sums of a cell is still exact.
+  const int tableWidth = horizontalBlocks * textWidth + 1;
+  const int tableHeight = verticalBlocks * textHeight + 1;
+  std::vector<unsigned int> table(tableWidth * tableHeight, 0);
+
+  std::vector<int> lines(tableHeight - 1);
+  std::iota(lines.begin(), lines.end(), 0);
+
+  auto sumLine = [&](int &y)
+  {
+    const auto line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+    auto row = table.data() + (y + 1) * tableWidth;
+
+    unsigned int sum = 0;
+    for(int x = 0; x < tableWidth - 1; ++x)
+    {
+      sum += qGray(line[x]);
+      row[x + 1] = sum;
+    }
+  };
+  // Parallel execution
+  std::for_each(std::execution::par, lines.begin(), lines.end(), sumLine);
+
+  for(int y = 2; y < tableHeight; ++y)
+  {
+    auto row = table.data() + y * tableWidth;
+    const auto above = row - tableWidth;
+    for(int x = 1; x < tableWidth; ++x)
+      row[x] += above[x];
+  }
+
+  std::vector<unsigned int> averages(horizontalBlocks * verticalBlocks);
+  const unsigned int cellArea = textWidth * textHeight;
+  for(int block = 0; block < horizontalBlocks * verticalBlocks; ++block)
+  {
+    const int charX = (block % horizontalBlocks) * textWidth;
+    const int charY = (block / horizontalBlocks) * textHeight;
+
+    const auto top = table.data() + charY * tableWidth + charX;
+    const auto bottom = top + textHeight * tableWidth;
+
+    averages[block] = (bottom[textWidth] - bottom[0] - top[textWidth] + top[0]) / cellArea;
+  }
+
+  return averages;
+}
@@ -0,0 +1,50 @@
+/*
+    File: AsciiArt.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASCII_ART_H_
+#define ASCII_ART_H_
+
+// Qt
+#include <QImage>
+#include <QSize>
+
+// C++
+#include <vector>
+
+namespace AsciiArt
+{
+  /** \brief Returns the average luma of the cells of the image, in rows, computed with a summed-area
+   *  table. Only the cells that fit completely in the image are returned, the pixels of the partial
+   *  cells at the right and bottom edges are not used.
+   * \param[in] image image in RGB32, ARGB32 or ARGB32 premultiplied format.
+   * \param[in] cell size of the cells.
+   *
+   */
+  std::vector<unsigned int> cellAverages(const QImage &image, const QSize &cell);
+
+  /** \brief Returns the index of the given average luma in a ramp of the given length.
+   * \param[in] average average luma in [0,255].
+   * \param[in] rampLength number of characters of the ramp.
+   *
+   */
+  inline unsigned int rampIndex(const unsigned int average, const int rampLength)
+  { return (average * (rampLength - 1)) / 255; }
+}
+
+#endif // ASCII_ART_H_
@@ -0,0 +1,485 @@
+/*
+    File: AsyncFileWriter.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <AsyncFileWriter.h>
+#include <Crc32.h>
+
+// Qt
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// C++
+#include <algorithm>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------
+AsyncFileWriter::AsyncFileWriter(const QString &fileName, const Durability durability, const qint64 preallocation, const Mode mode)
+: m_file         {nullptr}
+, m_durability   {durability}
+, m_preallocation{preallocation}
+, m_position     {0}
+, m_size         {0}
+, m_queued       {0}
+, m_processed    {0}
+, m_stopped      {false}
+{
+  m_buffer.type   = Request::Type::WRITE;
+  m_buffer.offset = 0;
+  m_buffer.data.reserve(BUFFER_SIZE);
+
+  m_file = fopen(fileName.toStdString().c_str(), mode == Mode::UPDATE ? "r+b" : "w+b");
+  if(!m_file)
+  {
+    qDebug() << "Unable to open file" << fileName;
+    return;
+  }
+
+  if(mode == Mode::UPDATE)
+  {
+    fseeko(m_file, 0, SEEK_END);
+    m_size = ftello(m_file);
+  }
+
+  // the buffers are ours, stdio buffering only adds a copy.
+  setvbuf(m_file, nullptr, _IONBF, 0);
+
+#ifdef __linux__
+  if(m_preallocation > 0)
+  {
+    // reserve the blocks without changing the file size, the file stays valid if the application crashes.
+    if(fallocate(fileno(m_file), FALLOC_FL_KEEP_SIZE, 0, m_preallocation) != 0)
+    {
+      qDebug() << "Unable to preallocate" << m_preallocation << "bytes for" << fileName;
+    }
+  }
+#endif
+}
+
+//------------------------------------------------------------------
+AsyncFileWriter::~AsyncFileWriter()
+{
+  close();
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::write(const void *data, unsigned long length)
+{
+  const auto bytes = static_cast<const char *>(data);
+
+  if(m_buffer.data.empty())
+  {
+    m_buffer.offset = m_position;
+  }
+
+  // overwrite the part of the buffer after the position (patches of pending data) and append the rest.
+  const auto relative = static_cast<unsigned long>(m_position - m_buffer.offset);
+  Q_ASSERT(relative <= m_buffer.data.size());
+
+  const auto overwrite = std::min(length, static_cast<unsigned long>(m_buffer.data.size() - relative));
+  if(overwrite > 0)
+  {
+    ::memcpy(m_buffer.data.data() + relative, bytes, overwrite);
+  }
+  m_buffer.data.insert(m_buffer.data.end(), bytes + overwrite, bytes + length);
+
+  m_position += length;
+  m_size = std::max(m_size, m_position);
+
+  if(m_buffer.data.size() >= BUFFER_SIZE && m_position == m_buffer.offset + static_cast<off_t>(m_buffer.data.size()))
+  {
+    submitBuffer();
+  }
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::seek(off_t position)
+{
+  // positions inside or at the end of the pending buffer are patched in memory.
+  const auto bufferEnd = m_buffer.offset + static_cast<off_t>(m_buffer.data.size());
+  if(!m_buffer.data.empty() && (position < m_buffer.offset || position > bufferEnd))
+  {
+    submitBuffer();
+  }
+
+  m_position = position;
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::resize(off_t size)
+{
+  flush();
+
+  // the writer thread is idle after the flush.
+  if(m_file)
+  {
+    fflush(m_file);
+#ifdef _WIN32
+    const auto result = _chsize_s(_fileno(m_file), size);
+#else
+    const auto result = ftruncate(fileno(m_file), size);
+#endif
+    if(result != 0)
+    {
+      qDebug() << "Unable to resize the file to" << size << "bytes.";
+      return;
+    }
+  }
+
+  m_size          = size;
+  m_position      = std::min(m_position, size);
+  m_buffer.offset = m_position;
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::syncPoint()
+{
+  if(m_durability == Durability::PER_CLUSTER)
+  {
+    sync();
+  }
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::sync()
+{
+  submitBuffer();
+
+  Request request;
+  request.type   = Request::Type::SYNC;
+  request.offset = 0;
+
+  queue(std::move(request));
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::checksum(off_t start, off_t end, off_t position)
+{
+  // the data still in the buffer must reach the file before it's read back.
+  submitBuffer();
+
+  Request request;
+  request.type   = Request::Type::CHECKSUM;
+  request.offset = start;
+  request.end    = end;
+  request.target = position;
+
+  queue(std::move(request));
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::flush()
+{
+  submitBuffer();
+  queueAndWait(Request::Type::FLUSH);
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::close()
+{
+  if(isRunning())
+  {
+    submitBuffer();
+    queueAndWait(Request::Type::STOP);
+    wait();
+  }
+
+  if(m_file)
+  {
+#ifdef __linux__
+    // the reserved blocks past the end of the file stay allocated after closing it.
+    if(m_preallocation > 0 && ftruncate(fileno(m_file), m_size) != 0)
+    {
+      qDebug() << "Unable to release the preallocated space of the file.";
+    }
+#endif
+
+    if(m_durability != Durability::NONE)
+    {
+      syncFile();
+    }
+
+    fclose(m_file);
+    m_file = nullptr;
+
+    const auto stats = metrics();
+    qDebug() << "Written" << stats.bytesWritten << "bytes in" << stats.writes << "writes, peak queued" << stats.peakBytesQueued
+             << "bytes, write latency avg" << (stats.writes == 0 ? 0 : stats.totalLatency / stats.writes) << "us max" << stats.maxLatency
+             << "us," << stats.syncs << "syncs, max sync latency" << stats.maxSyncLatency << "us.";
+  }
+}
+
+//------------------------------------------------------------------
+AsyncFileWriter::Metrics AsyncFileWriter::metrics() const
+{
+  QMutexLocker lock(&m_mutex);
+  return m_metrics;
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::run()
+{
+  QElapsedTimer syncTimer;
+  syncTimer.start();
+  bool dirty = false; /** true if there is data written since the last sync. */
+
+  while(true)
+  {
+    Request request;
+    bool timedSync = false;
+
+    {
+      QMutexLocker lock(&m_mutex);
+      while(m_queue.empty())
+      {
+        if(m_durability == Durability::PERIODIC)
+        {
+          const auto remaining = SYNC_INTERVAL - syncTimer.elapsed();
+          if(remaining <= 0 || !m_requestReady.wait(&m_mutex, static_cast<unsigned long>(remaining)))
+          {
+            break;
+          }
+        }
+        else
+        {
+          m_requestReady.wait(&m_mutex);
+        }
+      }
+
+      if(!m_queue.empty())
+      {
+        request = std::move(m_queue.front());
+        m_queue.pop_front();
+      }
+      else
+      {
+        request.type   = Request::Type::SYNC;
+        request.offset = 0;
+        timedSync      = true;
+      }
+    }
+
+    switch(request.type)
+    {
+      case Request::Type::WRITE:
+        if(m_file)
+        {
+          QElapsedTimer timer;
+          timer.start();
+
+          fseeko(m_file, request.offset, SEEK_SET);
+          if(fwrite(request.data.data(), 1, request.data.size(), m_file) != request.data.size())
+          {
+            qDebug() << "Error writing" << request.data.size() << "bytes at offset" << request.offset;
+          }
+
+          const auto latency = timer.nsecsElapsed() / 1000;
+
+          QMutexLocker lock(&m_mutex);
+          m_metrics.bytesWritten += request.data.size();
+          m_metrics.bytesQueued  -= request.data.size();
+          m_metrics.totalLatency += latency;
+          m_metrics.maxLatency    = std::max(m_metrics.maxLatency, latency);
+          ++m_metrics.writes;
+          dirty = true;
+        }
+        break;
+      case Request::Type::CHECKSUM:
+        writeChecksum(request);
+        dirty = true;
+        break;
+      case Request::Type::SYNC:
+        if(!timedSync || dirty)
+        {
+          syncFile();
+          dirty = false;
+        }
+        syncTimer.restart();
+        break;
+      default:
+      case Request::Type::FLUSH:
+      case Request::Type::STOP:
+        break;
+    }
+
+    if(m_durability == Durability::PERIODIC && dirty && syncTimer.elapsed() >= SYNC_INTERVAL)
+    {
+      syncFile();
+      syncTimer.restart();
+      dirty = false;
+    }
+
+    // timed syncs are not counted as processed requests.
+    if(!timedSync)
+    {
+      QMutexLocker lock(&m_mutex);
+      ++m_processed;
+      if(request.type == Request::Type::WRITE)
+      {
+        request.data.clear();
+        m_free.push_back(std::move(request.data));
+      }
+
+      m_requestDone.wakeAll();
+
+      if(request.type == Request::Type::STOP)
+      {
+        m_stopped = true;
+        return;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------
+unsigned long AsyncFileWriter::queue(Request &&request)
+{
+  QMutexLocker lock(&m_mutex);
+
+  // back-pressure: wait for the writer if all the buffers are in use.
+  while(m_queue.size() >= static_cast<size_t>(BUFFERS))
+  {
+    m_requestDone.wait(&m_mutex);
+  }
+
+  if(request.type == Request::Type::WRITE)
+  {
+    m_metrics.bytesQueued    += request.data.size();
+    m_metrics.peakBytesQueued = std::max(m_metrics.peakBytesQueued, m_metrics.bytesQueued);
+  }
+
+  m_queue.push_back(std::move(request));
+  ++m_queued;
+
+  m_requestReady.wakeOne();
+
+  return m_queued;
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::submitBuffer()
+{
+  if(m_buffer.data.empty()) return;
+
+  Request request;
+  request.type   = Request::Type::WRITE;
+  request.offset = m_buffer.offset;
+  request.data   = std::move(m_buffer.data);
+
+  queue(std::move(request));
+
+  m_buffer.offset = m_position;
+  m_buffer.data.clear();
+
+  {
+    QMutexLocker lock(&m_mutex);
+    if(!m_free.empty())
+    {
+      m_buffer.data = std::move(m_free.back());
+      m_free.pop_back();
+    }
+  }
+
+  if(m_buffer.data.capacity() < BUFFER_SIZE)
+  {
+    m_buffer.data.reserve(BUFFER_SIZE);
+  }
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::queueAndWait(Request::Type type)
+{
+  Request request;
+  request.type   = type;
+  request.offset = 0;
+
+  const auto ticket = queue(std::move(request));
+
+  QMutexLocker lock(&m_mutex);
+  while(m_processed < ticket && !m_stopped)
+  {
+    m_requestDone.wait(&m_mutex);
+  }
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::writeChecksum(const Request &request)
+{
+  if(!m_file || request.end <= request.offset) return;
+
+  // the data has just been written, it's read back from the page cache.
+  std::vector<char> buffer(static_cast<size_t>(std::min<off_t>(BUFFER_SIZE, request.end - request.offset)));
+  quint32 crc = 0;
+  off_t position = request.offset;
+
+  fseeko(m_file, position, SEEK_SET);
+  while(position < request.end)
+  {
+    const auto length = static_cast<size_t>(std::min<off_t>(buffer.size(), request.end - position));
+    if(fread(buffer.data(), 1, length, m_file) != length)
+    {
+      qDebug() << "Error reading" << length << "bytes at offset" << position << "for the checksum";
+      return;
+    }
+
+    crc = crc32(buffer.data(), length, crc);
+    position += length;
+  }
+
+  const unsigned char value[4] = { static_cast<unsigned char>(crc),       static_cast<unsigned char>(crc >> 8),
+                                   static_cast<unsigned char>(crc >> 16), static_cast<unsigned char>(crc >> 24) };
+
+  fseeko(m_file, request.target, SEEK_SET);
+  if(fwrite(value, 1, sizeof(value), m_file) != sizeof(value))
+  {
+    qDebug() << "Error writing the checksum at offset" << request.target;
+  }
+}
+
+//------------------------------------------------------------------
+void AsyncFileWriter::syncFile()
+{
+  if(!m_file) return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  fflush(m_file);
+#if defined(_WIN32)
+  _commit(_fileno(m_file));
+#elif defined(__linux__)
+  fdatasync(fileno(m_file));
+#else
+  fsync(fileno(m_file));
+#endif
+
+  const auto latency = timer.nsecsElapsed() / 1000;
+
+  QMutexLocker lock(&m_mutex);
+  ++m_metrics.syncs;
+  m_metrics.maxSyncLatency = std::max(m_metrics.maxSyncLatency, latency);
+}
@@ -0,0 +1,233 @@
+/*
+    File: AsyncFileWriter.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASYNC_FILE_WRITER_H_
+#define ASYNC_FILE_WRITER_H_
+
+// Qt
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+
+// C++
+#include <stdio.h>
+#include <sys/types.h>
+#include <vector>
+#include <deque>
+
+/** \class AsyncFileWriter
+ *  \brief Writes a file in a separate thread. The data is accumulated in buffers that
+ *         are handed to the writer thread, so a slow disk doesn't block the caller
+ *         until all the buffers are full.
+ *
+ */
+class AsyncFileWriter
+: public QThread
+{
+  public:
+    /** \class Durability
+     * \brief Policy of the data synchronization to the disk.
+     */
+    enum class Durability : char
+    {
+      NONE = 0,   /** leave it to the operating system.            */
+      PERIODIC,   /** synchronize every SYNC_INTERVAL milliseconds. */
+      PER_CLUSTER /** synchronize on every sync point.              */
+    };
+
+    /** \class Mode
+     * \brief How the file is opened.
+     */
+    enum class Mode : char
+    {
+      CREATE = 0, /** create the file or truncate the existing one. */
+      UPDATE      /** modify an existing file in place.               */
+    };
+
+    /** \struct Metrics
+     * \brief Statistics of the writer.
+     */
+    struct Metrics
+    {
+      unsigned long long bytesWritten    = 0; /** bytes written to the file.                    */
+      unsigned long long bytesQueued     = 0; /** bytes waiting to be written.                  */
+      unsigned long long peakBytesQueued = 0; /** maximum number of bytes waiting to be written. */
+      unsigned long      writes          = 0; /** number of write operations.                   */
+      unsigned long      syncs           = 0; /** number of synchronizations to disk.           */
+      qint64             totalLatency    = 0; /** total time spent in writes, in microseconds.  */
+      qint64             maxLatency      = 0; /** maximum time of a write, in microseconds.      */
+      qint64             maxSyncLatency  = 0; /** maximum time of a sync, in microseconds.       */
+    };
+
+    /** \brief AsyncFileWriter class constructor. Opens the file, the thread must be started before writing.
+     * \param[in] fileName name of the file to write.
+     * \param[in] durability data synchronization policy.
+     * \param[in] preallocation number of bytes to reserve on disk for the file, 0 to disable.
+     * \param[in] mode file open mode.
+     *
+     */
+    explicit AsyncFileWriter(const QString &fileName, const Durability durability = Durability::NONE, const qint64 preallocation = 0, const Mode mode = Mode::CREATE);
+
+    /** \brief AsyncFileWriter class virtual destructor. Writes the pending data and closes the file.
+     *
+     */
+    virtual ~AsyncFileWriter();
+
+    /** \brief Returns true if the file has been opened correctly.
+     *
+     */
+    bool isOpen() const
+    { return m_file != nullptr; }
+
+    /** \brief Writes the data at the current position.
+     * \param[in] data raw pointer of the data to write.
+     * \param[in] length length of the data in bytes.
+     *
+     */
+    void write(const void *data, unsigned long length);
+
+    /** \brief Sets the position for the following writes.
+     * \param[in] position position in bytes from the beginning of the file.
+     *
+     */
+    void seek(off_t position);
+
+    /** \brief Returns the current write position.
+     *
+     */
+    off_t position() const
+    { return m_position; }
+
+    /** \brief Returns the size of the written file.
+     *
+     */
+    off_t size() const
+    { return m_size; }
+
+    /** \brief Writes the pending data and changes the size of the file. The thread must be running.
+     * \param[in] size new size of the file in bytes.
+     *
+     */
+    void resize(off_t size);
+
+    /** \brief Marks a point where the written data is consistent (a closed cluster). Synchronizes
+     *  the file to disk if the durability policy is PER_CLUSTER.
+     *
+     */
+    void syncPoint();
+
+    /** \brief Queues the computation of the CRC-32 of the file data between the given positions, written
+     *  in little endian at the given position. The writer thread reads the data back once written, the
+     *  range must not be modified afterwards.
+     * \param[in] start start of the data.
+     * \param[in] end end of the data.
+     * \param[in] position position of the 4 bytes of the checksum.
+     *
+     */
+    void checksum(off_t start, off_t end, off_t position);
+
+    /** \brief Queues a synchronization of the file to disk without waiting for it.
+     *
+     */
+    void sync();
+
+    /** \brief Waits until all the queued data has been written.
+     *
+     */
+    void flush();
+
+    /** \brief Writes the pending data, stops the thread and closes the file.
+     *
+     */
+    void close();
+
+    /** \brief Returns the writer statistics.
+     *
+     */
+    Metrics metrics() const;
+
+    virtual void run() final;
+
+    static constexpr unsigned long BUFFER_SIZE   = 1024*1024; /** size of a buffer in bytes.                      */
+    static constexpr int           BUFFERS       = 4;         /** maximum number of buffers in the queue.         */
+    static constexpr qint64        SYNC_INTERVAL = 10000;     /** milliseconds between syncs with PERIODIC policy. */
+
+  private:
+    /** \struct Request
+     * \brief Operation for the writer thread.
+     */
+    struct Request
+    {
+      enum class Type: char { WRITE = 0, FLUSH, SYNC, STOP, CHECKSUM };
+
+      Type              type;       /** type of operation.                      */
+      off_t             offset;     /** position of the data in the file.        */
+      std::vector<char> data;       /** data to write.                          */
+      off_t             end    = 0; /** end of the data of a checksum request.   */
+      off_t             target = 0; /** position of the checksum of the request. */
+    };
+
+    /** \brief Queues the request and wakes up the writer thread. Waits if the queue is full. Returns
+     *  the number of the request.
+     * \param[in] request request to queue.
+     *
+     */
+    unsigned long queue(Request &&request);
+
+    /** \brief Queues the current buffer.
+     *
+     */
+    void submitBuffer();
+
+    /** \brief Queues the given request and waits until it has been processed.
+     * \param[in] type request type.
+     *
+     */
+    void queueAndWait(Request::Type type);
+
+    /** \brief Computes and writes the checksum of the request. Must be called from the writer thread.
+     * \param[in] request checksum request.
+     *
+     */
+    void writeChecksum(const Request &request);
+
+    /** \brief Synchronizes the file data to disk. Must be called from the writer thread.
+     *
+     */
+    void syncFile();
+
+    FILE                *m_file;          /** file handle.                                        */
+    const Durability     m_durability;    /** data synchronization policy.                        */
+    const qint64         m_preallocation; /** bytes to preallocate on disk.                       */
+    off_t                m_position;      /** current write position.                            */
+    off_t                m_size;          /** size of the file.                                   */
+    Request              m_buffer;        /** buffer being filled.                               */
+    std::deque<Request>  m_queue;         /** requests waiting for the writer thread.             */
+    std::vector<std::vector<char>> m_free;/** buffers ready to be reused.                         */
+    unsigned long        m_queued;        /** number of requests queued.                          */
+    unsigned long        m_processed;     /** number of requests processed.                       */
+    bool                 m_stopped;       /** true if the thread has been stopped.                */
+    Metrics              m_metrics;       /** writer statistics.                                  */
+    mutable QMutex       m_mutex;         /** queue mutex.                                        */
+    QWaitCondition       m_requestReady;  /** signaled when a request has been queued.            */
+    QWaitCondition       m_requestDone;   /** signaled when a request has been processed.         */
+};
+
+#endif // ASYNC_FILE_WRITER_H_
@@ -0,0 +1,438 @@
+/*
+    File: Blend.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <Blend.h>
+
+// C++
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define BLEND_AVX2
+#endif
+
+namespace
+{
+  using Kernel = void (*)(quint32 *, const quint32 *, int);
+
+  /** \struct Kernels
+   * \brief Row functions of the supported composition modes.
+   */
+  struct Kernels
+  {
+    Kernel sourceOver;
+    Kernel plus;
+    Kernel multiply;
+  };
+
+  /** \brief Returns x/255 rounded the same way as the Qt raster engine, x must be at most 255*255.
+   * \param[in] x value to divide.
+   *
+   */
+  inline quint32 div255(const quint32 x)
+  {
+    return (x + (x >> 8) + 0x80) >> 8;
+  }
+
+  //------------------------------------------------------------------
+  void sourceOverScalar(quint32 *d, const quint32 *s, int length)
+  {
+    for(int i = 0; i < length; ++i)
+    {
+      const auto source = s[i];
+      const auto alpha = source >> 24;
+
+      if(alpha == 0xFF)
+      {
+        d[i] = source;
+      }
+      else if(source != 0)
+      {
+        const auto inverse = 0xFF - alpha;
+        quint32 result = 0;
+        for(int shift = 0; shift < 32; shift += 8)
+        {
+          const auto channel = ((source >> shift) & 0xFF) + div255(((d[i] >> shift) & 0xFF) * inverse);
+          result |= std::min(channel, 0xFFu) << shift;
+        }
+        d[i] = result;
+      }
+    }
+  }
+
+  //------------------------------------------------------------------
+  void plusScalar(quint32 *d, const quint32 *s, int length)
+  {
+    for(int i = 0; i < length; ++i)
+    {
+      quint32 result = 0;
+      for(int shift = 0; shift < 32; shift += 8)
+      {
+        const auto channel = ((s[i] >> shift) & 0xFF) + ((d[i] >> shift) & 0xFF);
+        result |= std::min(channel, 0xFFu) << shift;
+      }
+      d[i] = result;
+    }
+  }
+
+  //------------------------------------------------------------------
+  void multiplyScalar(quint32 *d, const quint32 *s, int length)
+  {
+    for(int i = 0; i < length; ++i)
+    {
+      const auto sa = s[i] >> 24;
+      const auto da = d[i] >> 24;
+
+      quint32 result = (0xFF - div255((0xFF - sa) * (0xFF - da))) << 24;
+      for(int shift = 0; shift < 24; shift += 8)
+      {
+        const auto sc = (s[i] >> shift) & 0xFF;
+        const auto dc = (d[i] >> shift) & 0xFF;
+        result |= div255(sc * dc + sc * (0xFF - da) + dc * (0xFF - sa)) << shift;
+      }
+      d[i] = result;
+    }
+  }
+
+#if defined(__SSE2__)
+  /** \brief SSE2 version of div255() for 16 bit lanes.
+   *
+   */
+  inline __m128i div255(const __m128i x)
+  {
+    const auto rounded = _mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(rounded, 8);
+  }
+
+  /** \brief Returns the alpha of each pixel in its four 16 bit lanes.
+   *
+   */
+  inline __m128i alphas(const __m128i x)
+  {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+  }
+
+  inline __m128i sourceOver(const __m128i d, const __m128i s)
+  {
+    const auto inverse = _mm_sub_epi16(_mm_set1_epi16(0xFF), alphas(s));
+    return _mm_add_epi16(s, div255(_mm_mullo_epi16(d, inverse)));
+  }
+
+  inline __m128i multiply(const __m128i d, const __m128i s)
+  {
+    const auto sInverse = _mm_sub_epi16(_mm_set1_epi16(0xFF), alphas(s));
+    const auto dInverse = _mm_sub_epi16(_mm_set1_epi16(0xFF), alphas(d));
+    const auto colors = div255(_mm_add_epi16(_mm_mullo_epi16(s, d), _mm_add_epi16(_mm_mullo_epi16(s, dInverse), _mm_mullo_epi16(d, sInverse))));
+    const auto alpha = _mm_sub_epi16(_mm_set1_epi16(0xFF), div255(_mm_mullo_epi16(sInverse, dInverse)));
+    const auto mask = _mm_set1_epi64x(static_cast<long long>(0xFFFF000000000000ull));
+    return _mm_or_si128(_mm_and_si128(mask, alpha), _mm_andnot_si128(mask, colors));
+  }
+
+  /** \brief Applies the 16 bit lanes operation to four pixels at a time.
+   *
+   */
+  template<__m128i (*Operation)(const __m128i, const __m128i)>
+  int blendSSE2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto zero = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 4 <= length; i += 4)
+    {
+      const auto source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      const auto destination = _mm_loadu_si128(reinterpret_cast<const __m128i *>(d + i));
+      const auto low = Operation(_mm_unpacklo_epi8(destination, zero), _mm_unpacklo_epi8(source, zero));
+      const auto high = Operation(_mm_unpackhi_epi8(destination, zero), _mm_unpackhi_epi8(source, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), _mm_packus_epi16(low, high));
+    }
+    return i;
+  }
+
+  //------------------------------------------------------------------
+  void sourceOverSSE2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto done = blendSSE2<sourceOver>(d, s, length);
+    sourceOverScalar(d + done, s + done, length - done);
+  }
+
+  //------------------------------------------------------------------
+  void plusSSE2(quint32 *d, const quint32 *s, int length)
+  {
+    int i = 0;
+    for(; i + 4 <= length; i += 4)
+    {
+      const auto source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      const auto destination = _mm_loadu_si128(reinterpret_cast<const __m128i *>(d + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), _mm_adds_epu8(source, destination));
+    }
+    plusScalar(d + i, s + i, length - i);
+  }
+
+  //------------------------------------------------------------------
+  void multiplySSE2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto done = blendSSE2<multiply>(d, s, length);
+    multiplyScalar(d + done, s + done, length - done);
+  }
+#endif
+
+#if defined(BLEND_AVX2)
+  // the AVX2 functions are compiled for that target only, they are called after checking the CPU.
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+  AVX2_TARGET inline __m256i div255(const __m256i x)
+  {
+    const auto rounded = _mm256_add_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(rounded, 8);
+  }
+
+  AVX2_TARGET inline __m256i alphas(const __m256i x)
+  {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+  }
+
+  AVX2_TARGET inline __m256i sourceOver(const __m256i d, const __m256i s)
+  {
+    const auto inverse = _mm256_sub_epi16(_mm256_set1_epi16(0xFF), alphas(s));
+    return _mm256_add_epi16(s, div255(_mm256_mullo_epi16(d, inverse)));
+  }
+
+  AVX2_TARGET inline __m256i multiply(const __m256i d, const __m256i s)
+  {
+    const auto sInverse = _mm256_sub_epi16(_mm256_set1_epi16(0xFF), alphas(s));
+    const auto dInverse = _mm256_sub_epi16(_mm256_set1_epi16(0xFF), alphas(d));
+    const auto colors = div255(_mm256_add_epi16(_mm256_mullo_epi16(s, d), _mm256_add_epi16(_mm256_mullo_epi16(s, dInverse), _mm256_mullo_epi16(d, sInverse))));
+    const auto alpha = _mm256_sub_epi16(_mm256_set1_epi16(0xFF), div255(_mm256_mullo_epi16(sInverse, dInverse)));
+    const auto mask = _mm256_set1_epi64x(static_cast<long long>(0xFFFF000000000000ull));
+    return _mm256_or_si256(_mm256_and_si256(mask, alpha), _mm256_andnot_si256(mask, colors));
+  }
+
+  /** \brief Applies the 16 bit lanes operation to eight pixels at a time. The unpack and pack
+   *  instructions work inside each 128 bit lane so the pixels keep their order.
+   *
+   */
+  template<__m256i (*Operation)(const __m256i, const __m256i)>
+  AVX2_TARGET int blendAVX2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto zero = _mm256_setzero_si256();
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+      const auto source = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+      const auto destination = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + i));
+      const auto low = Operation(_mm256_unpacklo_epi8(destination, zero), _mm256_unpacklo_epi8(source, zero));
+      const auto high = Operation(_mm256_unpackhi_epi8(destination, zero), _mm256_unpackhi_epi8(source, zero));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + i), _mm256_packus_epi16(low, high));
+    }
+    return i;
+  }
+
+  //------------------------------------------------------------------
+  AVX2_TARGET void sourceOverAVX2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto done = blendAVX2<sourceOver>(d, s, length);
+    sourceOverSSE2(d + done, s + done, length - done);
+  }
+
+  //------------------------------------------------------------------
+  AVX2_TARGET void plusAVX2(quint32 *d, const quint32 *s, int length)
+  {
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+      const auto source = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+      const auto destination = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(d + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + i), _mm256_adds_epu8(source, destination));
+    }
+    plusSSE2(d + i, s + i, length - i);
+  }
+
+  //------------------------------------------------------------------
+  AVX2_TARGET void multiplyAVX2(quint32 *d, const quint32 *s, int length)
+  {
+    const auto done = blendAVX2<multiply>(d, s, length);
+    multiplySSE2(d + done, s + done, length - done);
+  }
+
+#undef AVX2_TARGET
+#endif
+
+#if defined(__ARM_NEON)
+  /** \brief NEON version of div255() of the 16 bit products, narrowed to 8 bits.
+   *
+   */
+  inline uint8x8_t div255(const uint16x8_t x)
+  {
+    return vraddhn_u16(x, vshrq_n_u16(x, 8));
+  }
+
+  //------------------------------------------------------------------
+  void sourceOverNEON(quint32 *d, const quint32 *s, int length)
+  {
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+      // the pixels are deinterleaved in one register per channel, the alpha is the last one.
+      const auto source = vld4_u8(reinterpret_cast<const uint8_t *>(s + i));
+      auto destination = vld4_u8(reinterpret_cast<const uint8_t *>(d + i));
+      const auto inverse = vmvn_u8(source.val[3]);
+      for(int c = 0; c < 4; ++c)
+      {
+        destination.val[c] = vqadd_u8(source.val[c], div255(vmull_u8(destination.val[c], inverse)));
+      }
+      vst4_u8(reinterpret_cast<uint8_t *>(d + i), destination);
+    }
+    sourceOverScalar(d + i, s + i, length - i);
+  }
+
+  //------------------------------------------------------------------
+  void plusNEON(quint32 *d, const quint32 *s, int length)
+  {
+    int i = 0;
+    for(; i + 4 <= length; i += 4)
+    {
+      const auto source = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+      const auto destination = vld1q_u8(reinterpret_cast<const uint8_t *>(d + i));
+      vst1q_u8(reinterpret_cast<uint8_t *>(d + i), vqaddq_u8(source, destination));
+    }
+    plusScalar(d + i, s + i, length - i);
+  }
+
+  //------------------------------------------------------------------
+  void multiplyNEON(quint32 *d, const quint32 *s, int length)
+  {
+    int i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+      const auto source = vld4_u8(reinterpret_cast<const uint8_t *>(s + i));
+      auto destination = vld4_u8(reinterpret_cast<const uint8_t *>(d + i));
+      const auto sInverse = vmvn_u8(source.val[3]);
+      const auto dInverse = vmvn_u8(destination.val[3]);
+      for(int c = 0; c < 3; ++c)
+      {
+        auto products = vmull_u8(source.val[c], destination.val[c]);
+        products = vmlal_u8(products, source.val[c], dInverse);
+        products = vmlal_u8(products, destination.val[c], sInverse);
+        destination.val[c] = div255(products);
+      }
+      destination.val[3] = vmvn_u8(div255(vmull_u8(sInverse, dInverse)));
+      vst4_u8(reinterpret_cast<uint8_t *>(d + i), destination);
+    }
+    multiplyScalar(d + i, s + i, length - i);
+  }
+#endif
+
+  /** \brief Returns the kernels for the CPU, selected on the first call.
+   *
+   */
+  const Kernels &kernels()
+  {
+    static const Kernels selected = []()
+    {
+#if defined(BLEND_AVX2)
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2"))
+        return Kernels{sourceOverAVX2, plusAVX2, multiplyAVX2};
+#endif
+#if defined(__SSE2__)
+      return Kernels{sourceOverSSE2, plusSSE2, multiplySSE2};
+#elif defined(__ARM_NEON)
+      return Kernels{sourceOverNEON, plusNEON, multiplyNEON};
+#else
+      return Kernels{sourceOverScalar, plusScalar, multiplyScalar};
+#endif
+    }();
+
+    return selected;
+  }
+
+  /** \brief Returns the kernel of the composition mode or nullptr if not supported.
+   * \param[in] functions kernels.
+   * \param[in] mode composition mode.
+   *
+   */
+  Kernel kernel(const Kernels &functions, QPainter::CompositionMode mode)
+  {
+    switch(mode)
+    {
+      case QPainter::CompositionMode_SourceOver:
+        return functions.sourceOver;
+      case QPainter::CompositionMode_Plus:
+        return functions.plus;
+      case QPainter::CompositionMode_Multiply:
+        return functions.multiply;
+      default:
+        break;
+    }
+
+    return nullptr;
+  }
+
+  const Kernels REFERENCE{sourceOverScalar, plusScalar, multiplyScalar};
+}
+
+//------------------------------------------------------------------
+void Blend::blendRow(quint32 *destination, const quint32 *source, int length, QPainter::CompositionMode mode)
+{
+  const auto function = kernel(kernels(), mode);
+  if(function) function(destination, source, length);
+}
+
+//------------------------------------------------------------------
+void Blend::blendRowReference(quint32 *destination, const quint32 *source, int length, QPainter::CompositionMode mode)
+{
+  const auto function = kernel(REFERENCE, mode);
+  if(function) function(destination, source, length);
+}
+
+//------------------------------------------------------------------
+bool Blend::drawImage(QImage &destination, const QPoint &position, const QImage &source, QPainter::CompositionMode mode)
+{
+  const auto function = kernel(kernels(), mode);
+  if(!function) return false;
+
+  const auto format = destination.format();
+  if(format != QImage::Format_RGB32 && format != QImage::Format_ARGB32_Premultiplied) return false;
+
+  // the results of the three modes over an opaque pixel are opaque, RGB32 destinations stay valid.
+  auto image = source;
+  if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+  {
+    image = source.convertToFormat(source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+  }
+
+  const auto area = QRect{position, image.size()}.intersected(destination.rect());
+  if(area.isEmpty()) return true;
+
+  for(int y = area.top(); y <= area.bottom(); ++y)
+  {
+    auto d = reinterpret_cast<quint32 *>(destination.scanLine(y)) + area.left();
+    auto s = reinterpret_cast<const quint32 *>(image.constScanLine(y - position.y())) + (area.left() - position.x());
+    function(d, s, area.width());
+  }
+
+  return true;
+}
@@ -0,0 +1,62 @@
+/*
+    File: Blend.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLEND_H_
+#define BLEND_H_
+
+// Qt
+#include <QImage>
+#include <QPainter>
+
+namespace Blend
+{
+  /** \brief Blends a row of premultiplied ARGB32 pixels over another one with the same formulas and
+   *  rounding of the Qt raster engine. Only SourceOver, Plus and Multiply are supported. Uses the
+   *  widest SIMD instructions of the CPU (AVX2 or SSE2 in x86, NEON in ARM).
+   * \param[inout] destination destination pixels.
+   * \param[in] source source pixels.
+   * \param[in] length number of pixels.
+   * \param[in] mode composition mode.
+   *
+   */
+  void blendRow(quint32 *destination, const quint32 *source, int length, QPainter::CompositionMode mode);
+
+  /** \brief Scalar version of blendRow(), the reference of the SIMD kernels.
+   * \param[inout] destination destination pixels.
+   * \param[in] source source pixels.
+   * \param[in] length number of pixels.
+   * \param[in] mode composition mode.
+   *
+   */
+  void blendRowReference(quint32 *destination, const quint32 *source, int length, QPainter::CompositionMode mode);
+
+  /** \brief Draws the source image over the destination at the given position, the same as
+   *  QPainter::drawImage() with the given composition mode. Returns false, without modifying
+   *  the destination, if the mode or the destination format are not supported and QPainter
+   *  must be used instead.
+   * \param[inout] destination destination image, in RGB32 or ARGB32 premultiplied format.
+   * \param[in] position position of the top left corner of the source in the destination.
+   * \param[in] source source image, converted if not in RGB32 or ARGB32 premultiplied format.
+   * \param[in] mode composition mode.
+   *
+   */
+  bool drawImage(QImage &destination, const QPoint &position, const QImage &source, QPainter::CompositionMode mode);
+}
+
+#endif // BLEND_H_
@@ -0,0 +1,53 @@
+/*
+    File: CameraImage.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CameraImage.h>
+
+// Qt
+#include <QDebug>
+
+//-----------------------------------------------------------------
+QImage CameraImage::MatToQImage(const cv::Mat& mat)
+{
+  if (mat.type() == CV_8UC1) // 8-bits unsigned, NO. OF CHANNELS=1
+  {
+    // Wrap input Mat
+    const uchar *qImageBuffer = (const uchar*) mat.data;
+
+    // Create QImage with same dimensions as input Mat, gray levels don't need a color table.
+    return QImage(qImageBuffer, mat.cols, mat.rows, mat.step, QImage::Format_Grayscale8);
+  }
+  else // 8-bits unsigned, NO. OF CHANNELS=3
+  {
+    if (mat.type() == CV_8UC3)
+    {
+      // Wrap input Mat
+      const uchar *qImageBuffer = (const uchar*) mat.data;
+
+      // Create QImage with same dimensions as input Mat, in the BGR order of OpenCV.
+      return QImage(qImageBuffer, mat.cols, mat.rows, mat.step, QImage::Format_BGR888);
+    }
+    else
+    {
+      qDebug() << "ERROR: Mat could not be converted to QImage. Mat type is" << mat.type();
+      return QImage();
+    }
+  }
+}
@@ -0,0 +1,40 @@
+/*
+    File: CameraImage.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAMERA_IMAGE_H_
+#define CAMERA_IMAGE_H_
+
+// Qt
+#include <QImage>
+
+// OpenCV
+#include <opencv2/core/mat.hpp>
+
+namespace CameraImage
+{
+  /** \brief Converts a MAT image from OpenCV to a Qt QImage. The image wraps the data of
+   *  the mat without copying it and is only valid while the mat data is. Returns a null
+   *  image if the mat is not 8 bits gray or BGR.
+   * \param[in] mat reference to a OpenCV mat image.
+   *
+   */
+  QImage MatToQImage(const cv::Mat& mat);
+}
+
+#endif // CAMERA_IMAGE_H_
@@ -20,10 +20,14 @@
 // C++
 #undef __cpuid
 #include <algorithm>
+#include <cmath>
 #include <execution>
 
 // Project
 #include <CaptureDesktopThread.h>
+#include <AsciiArt.h>
+#include <Blend.h>
+#include <CameraImage.h>
 #include <Utils.h>
 
 // Qt
@@ -40,13 +44,21 @@
 #include <QDir>
 #include <QScreen>
 #include <QTemporaryFile>
-#include <QGraphicsPixmapItem>
+#include <QPainterPath>
 #include <QDebug>
 
+// OpenCV
+#include <opencv2/imgproc/imgproc.hpp>
+
 // dLib
 #include <dlib/opencv.h>
 #include <dlib/gui_widgets.h>
 
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 const QList<QPainter::CompositionMode> COMPOSITION_MODES_QT = { QPainter::CompositionMode_SourceOver,
 		                                                            QPainter::CompositionMode_Plus,
 		                                                            QPainter::CompositionMode_Multiply };
@@ -74,14 +86,20 @@ CaptureDesktopThread::CaptureDesktopThread(int monitor, Resolution cameraResolut
 : QThread          {parent}
 , m_aborted        {false}
 , m_paused         {false}
+, m_imageTimestamp {0}
+, m_normalizeCamera{false}
 , m_cameraEnabled  {false}
 , m_compositionMode{COMPOSITION_MODE::COPY}
 , m_statisticsMode {COMPOSITION_MODE::COPY}
 , m_drawFrame      {false}
 , m_mask           {MASK::NONE}
+, m_maskLoaded     {-1}
 , m_trackFace      {false}
 , m_trackFaceSmooth{false}
 , m_ASCII_Art      {false}
+, m_cameraSeparate {false}
+, m_overlaySprites {false}
+, m_textOverlays   {true}
 , m_ramp           {0}
 , m_rampCharSize   {10}
 , m_timeTextSize   {40}
@@ -89,7 +107,10 @@ CaptureDesktopThread::CaptureDesktopThread(int monitor, Resolution cameraResolut
 , m_timeBackground {true}
 , m_timeTextColor  {QColor(255,255,255)}
 , m_pomodoro       {nullptr}
+, m_statsOpacity   {1.0}
+, m_statsDirty     {true}
 {
+	m_clock.start();
 	setMonitor(monitor);
 
 	if (cameraResolution.name != QString())
@@ -162,6 +183,46 @@ void CaptureDesktopThread::setCameraEnabled(bool enabled)
 	}
 }
 
+//-----------------------------------------------------------------
+void CaptureDesktopThread::setCameraSeparateTrack(bool enabled)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_cameraSeparate = enabled;
+	m_cameraImage = QImage();
+}
+
+//-----------------------------------------------------------------
+QImage CaptureDesktopThread::getCameraImage()
+{
+  QMutexLocker lock(&m_mutex);
+  return m_cameraImage;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::setOverlaySprites(bool enabled)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_overlaySprites = enabled;
+	m_sprites.clear();
+}
+
+//-----------------------------------------------------------------
+QList<I420Overlay::Sprite> CaptureDesktopThread::getOverlaySprites()
+{
+  QMutexLocker lock(&m_mutex);
+  return m_sprites;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::setTextOverlaysEnabled(bool enabled)
+{
+	QMutexLocker lock(&m_mutex);
+
+	m_textOverlays = enabled;
+}
+
 //-----------------------------------------------------------------
 QPixmap* CaptureDesktopThread::getImage()
 {
@@ -169,6 +230,20 @@ QPixmap* CaptureDesktopThread::getImage()
 	return &m_image;
 }
 
+//-----------------------------------------------------------------
+qint64 CaptureDesktopThread::getImageTimestamp()
+{
+  QMutexLocker lock(&m_mutex);
+  return m_imageTimestamp;
+}
+
+//-----------------------------------------------------------------
+QList<QRect> CaptureDesktopThread::getRegionsOfInterest()
+{
+  QMutexLocker lock(&m_mutex);
+  return m_regions;
+}
+
 //-----------------------------------------------------------------
 void CaptureDesktopThread::pause()
 {
@@ -246,7 +321,25 @@ void CaptureDesktopThread::setPomodoro(std::shared_ptr<Pomodoro> pomodoro)
 {
 	QMutexLocker lock(&m_mutex);
 
+	if (m_pomodoro)
+		disconnect(m_pomodoro.get(), nullptr, this, nullptr);
+
 	m_pomodoro = pomodoro;
+
+	// the completed units only change when a unit begins or ends.
+	if (m_pomodoro)
+	{
+		connect(m_pomodoro.get(), SIGNAL(beginPomodoro()),    this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(pomodoroEnded()),    this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(beginShortBreak()),  this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(shortBreakEnded()),  this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(beginLongBreak()),   this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(longBreakEnded()),   this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(sessionEnded()),     this, SLOT(invalidateStatsOverlay()));
+		connect(m_pomodoro.get(), SIGNAL(taskTitleChanged()), this, SLOT(invalidateStatsOverlay()));
+	}
+
+	m_statsDirty = true;
 }
 
 //-----------------------------------------------------------------
@@ -336,6 +429,14 @@ void CaptureDesktopThread::setCameraAsASCII(bool enabled)
     m_ASCII_Art = enabled;
 }
 
+//-----------------------------------------------------------------
+void CaptureDesktopThread::setCameraNormalized(bool enabled)
+{
+  QMutexLocker lock(&m_mutex);
+
+  m_normalizeCamera = enabled;
+}
+
 //-----------------------------------------------------------------
 void CaptureDesktopThread::setTimeOverlayTextSize(int value)
 {
@@ -420,30 +521,62 @@ void CaptureDesktopThread::drawMask(QImage& cameraImage, dlib::full_object_detec
   }
  
   // Transform and paint the mask.
-  QImage mask;
-  mask.load(MASKS[maskIndex].resource);
+  if(m_maskLoaded != maskIndex)
+    loadMask(maskIndex);
+
+  if(m_maskLevels.isEmpty()) return;
 
   QLineF line(QPoint(lx, ly), QPoint(rx, ry));
-  line.angle();
 
   const auto eyeDistance = std::sqrt(std::pow(rx - lx, 2) + std::pow(ry - ly, 2));
   const auto lipDistance = std::sqrt(std::pow(((lx + rx) / 2) - mx, 2) + std::pow(((ly + ry) / 2) - my, 2));
   const auto widthRatio = eyeDistance / MASKS[maskIndex].eyeDistance;
   const auto heightRatio = lipDistance / MASKS[maskIndex].lipDistance;
 
-  QTransform transform;
-  transform.scale(widthRatio, heightRatio);
-  mask = mask.transformed(transform, Qt::SmoothTransformation);
-  const auto rotatedLeftEye = transform.map(MASKS[maskIndex].leftEye);
+  // smallest level still bigger than the painted mask, the warp never shrinks it to less than a half.
+  const auto ratio = std::max(widthRatio, heightRatio);
+  const auto &original = m_maskLevels.first();
+  int level = 0;
+  while(level + 1 < m_maskLevels.size() && static_cast<double>(m_maskLevels.at(level + 1).width()) / original.width() >= ratio)
+    ++level;
 
+  const auto &mask = m_maskLevels.at(level);
+  const auto levelX = static_cast<double>(mask.width()) / original.width();
+  const auto levelY = static_cast<double>(mask.height()) / original.height();
+  const auto leftEye = MASKS[maskIndex].leftEye;
+
+  // a single warp of the level, the left eye of the mask goes to the left eye of the face.
   QPainter painter(&cameraImage);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
   painter.translate(QPoint(lx, ly));
   painter.rotate(-line.angle());
-  painter.translate(-rotatedLeftEye.x(), -rotatedLeftEye.y());
+  painter.scale(widthRatio / levelX, heightRatio / levelY);
+  painter.translate(-leftEye.x() * levelX, -leftEye.y() * levelY);
   painter.drawImage(QPoint(0, 0), mask);
   painter.end();
 }
 
+//-----------------------------------------------------------------
+void CaptureDesktopThread::loadMask(const int maskIndex)
+{
+  m_maskLevels.clear();
+  m_maskLoaded = maskIndex;
+
+  QImage mask;
+  if(!mask.load(MASKS[maskIndex].resource))
+  {
+    qDebug() << "Unable to load mask" << MASKS[maskIndex].resource;
+    return;
+  }
+
+  m_maskLevels << mask.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  while(std::min(m_maskLevels.last().width(), m_maskLevels.last().height()) / 2 >= MASK_MIN_LEVEL_SIZE)
+  {
+    const auto &previous = m_maskLevels.last();
+    m_maskLevels << previous.scaled(previous.width() / 2, previous.height() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  }
+}
+
 //-----------------------------------------------------------------
 void CaptureDesktopThread::drawCameraImageFrame(QImage &image)
 {
@@ -543,6 +676,7 @@ QPoint CaptureDesktopThread::computePosition(const POSITION position, const QRec
 void CaptureDesktopThread::setStatisticsOverlayCompositionMode(const COMPOSITION_MODE mode)
 {
   m_statisticsMode = mode;
+  m_statsDirty = true;
 }
 
 //-----------------------------------------------------------------
@@ -580,61 +714,17 @@ void CaptureDesktopThread::setTimeOverlayPosition(const POSITION position)
 }
 
 //-----------------------------------------------------------------
-QImage CaptureDesktopThread::MatToQImage(const cv::Mat& mat)
-{
-  if (mat.type() == CV_8UC1) // 8-bits unsigned, NO. OF CHANNELS=1
-  {
-    // Set the color table (used to translate color indexes to qRgb values)
-    QVector<QRgb> colorTable;
-    for (int i = 0; i < 256; i++)
-      colorTable.push_back(qRgb(i, i, i));
-
-    // Copy input Mat
-    const uchar *qImageBuffer = (const uchar*) mat.data;
-
-    // Create QImage with same dimensions as input Mat
-    QImage img(qImageBuffer, mat.cols, mat.rows, mat.step, QImage::Format_Indexed8);
-    img.setColorTable(colorTable);
-
-    return img;
-  }
-  else // 8-bits unsigned, NO. OF CHANNELS=3
-  {
-    if (mat.type() == CV_8UC3)
-    {
-      // Copy input Mat
-      const uchar *qImageBuffer = (const uchar*) mat.data;
-
-      // Create QImage with same dimensions as input Mat
-      QImage img(qImageBuffer, mat.cols, mat.rows, mat.step, QImage::Format_RGB888);
-      return img.rgbSwapped();
-    }
-    else
-    {
-      qDebug() << "ERROR: Mat could not be converted to QImage. Mat type is" << mat.type();
-      return QImage();
-    }
-  }
-}
-
-//-----------------------------------------------------------------
-void CaptureDesktopThread::overlayCameraImage(QImage &baseImage, QImage &overlayImage)
+void CaptureDesktopThread::overlayCameraImage(QImage &overlayImage)
 {
   dlib::full_object_detection shapes;
 
   if(m_mask != MASK::NONE || m_trackFace)
   {
-    double luma = 0;
-    long i = 0;
+    // the frame is already normalized if the camera picture is.
+    if(!m_normalizeCamera)
+      normalizeBrightness(m_frame, m_detectorFrame);
 
-    for(auto buf = m_frame.datastart; buf < m_frame.dataend; buf += 3, ++i)
-      luma += (buf[2]*0.299) + (buf[1]*0.587) + (buf[0]*0.144);
-
-    luma /= i;
-
-    cv::normalize(m_frame, m_frame, 255, 128 - static_cast<int>(luma), cv::NORM_MINMAX);
-
-    dlib::cv_image<dlib::bgr_pixel> cimg(m_frame);
+    dlib::cv_image<dlib::bgr_pixel> cimg(m_normalizeCamera ? m_frame : m_detectorFrame);
     const auto faces = m_faceDetector(cimg);
 
     if(!faces.empty())
@@ -667,13 +757,45 @@ void CaptureDesktopThread::overlayCameraImage(QImage &baseImage, QImage &overlay
   if(m_ASCII_Art)
     imageToASCII(overlayImage);
 
-  QPainter painter(&baseImage);
-  painter.setCompositionMode(COMPOSITION_MODES_QT.at(static_cast<int>(m_compositionMode)));
-  painter.drawImage(m_cameraPosition.x(), m_cameraPosition.y(), overlayImage);
-  painter.end();
+  if(m_cameraSeparate)
+  {
+    QMutexLocker lock(&m_mutex);
+    m_cameraImage = overlayImage;
+    return;
+  }
 
-  if (m_drawFrame)
-    drawCameraImageFrame(baseImage);
+  // the camera picture is new in every capture, the layer is always dirty.
+  auto &layer = m_layers[static_cast<int>(LAYER::CAMERA)];
+  layer.sprite = overlayImage;
+  layer.position = m_cameraPosition;
+  layer.mode = m_compositionMode;
+  layer.visible = true;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::normalizeBrightness(const cv::Mat &source, cv::Mat &destination)
+{
+  constexpr double PROXY_SCALE = 1.0/CAMERA_PROXY_STEP;
+  cv::resize(source, m_cameraProxy, cv::Size(), PROXY_SCALE, PROXY_SCALE, cv::INTER_NEAREST);
+
+  const auto mean = cv::mean(m_cameraProxy);
+  const auto luma = (mean[2]*0.299) + (mean[1]*0.587) + (mean[0]*0.114);
+
+  double minimum, maximum;
+  cv::minMaxLoc(m_cameraProxy.reshape(1), &minimum, &maximum);
+
+  // same range and mapping as cv::normalize(source, destination, 255, 128 - luma, cv::NORM_MINMAX).
+  const int lower = 128 - static_cast<int>(luma);
+  const int minValue = static_cast<int>(minimum);
+  const int range = static_cast<int>(maximum) - minValue;
+  const qint64 scale = range > 0 ? (static_cast<qint64>(255 - lower) << 16) / range : 0; // 16.16 fixed point.
+
+  cv::Mat table(1, 256, CV_8U);
+  auto entries = table.ptr<uchar>();
+  for(int i = 0; i < 256; ++i)
+    entries[i] = static_cast<uchar>(std::clamp<qint64>(lower + (((i - minValue) * scale + 0x8000) >> 16), 0, 255));
+
+  cv::LUT(source, table, destination);
 }
 
 //-----------------------------------------------------------------
@@ -698,92 +820,169 @@ int CaptureDesktopThread::pomodoroOverlayHeight()
   return 0;
 }
 
+//-----------------------------------------------------------------
+QRect CaptureDesktopThread::activeWindowGeometry() const
+{
+  QRect geometry;
+
+#ifdef _WIN32
+  RECT rect;
+  const auto window = GetForegroundWindow();
+  if(window && !IsIconic(window) && GetWindowRect(window, &rect))
+  {
+    geometry = QRect{QPoint{rect.left, rect.top}, QPoint{rect.right - 1, rect.bottom - 1}};
+  }
+#endif
+
+  return geometry.translated(-m_geometry.topLeft()).intersected(QRect{QPoint{0,0}, m_geometry.size()});
+}
+
 //-----------------------------------------------------------------
 void CaptureDesktopThread::imageToASCII(QPixmap &image)
 {
-  auto qImage = image.toImage();
-  imageToASCII(qImage);
-  image = QPixmap::fromImage(qImage);
+  // the image of a raster pixmap shares its buffer, only the art image is new.
+  const auto source = image.toImage();
+  QImage art(source.size(), QImage::Format_RGB32);
+  imageToASCII(source, art);
+  image = QPixmap::fromImage(std::move(art));
 }
 
 //-----------------------------------------------------------------
 void CaptureDesktopThread::imageToASCII(QImage &image)
 {
-  const auto ramp = RAMPS.at(m_ramp).value;
-  const auto rampLength = ramp.length();
+  // the cells are written directly in the scan lines, opaque over black.
+  if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+  {
+    image.convertTo(QImage::Format_RGB32);
+  }
 
-  QFont font;
-  font.setBold(true);
-  font.setFixedPitch(true);
-  font.setPixelSize(m_rampCharSize);
+  imageToASCII(image, image);
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::imageToASCII(const QImage &source, QImage &destination)
+{
+  if(m_asciiGlyphs.ramp != m_ramp || m_asciiGlyphs.size != m_rampCharSize)
+  {
+    renderAsciiGlyphs();
+  }
+
+  QImage converted;
+  const QImage *image = &source;
+  if(source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32 && source.format() != QImage::Format_ARGB32_Premultiplied)
+  {
+    converted = source.convertToFormat(QImage::Format_RGB32);
+    image = &converted;
+  }
 
-  QFontMetrics fm(font);
-  const int textWidth  = fm.boundingRect("A").width();
-  const int textHeight = fm.height();
-  const int horizontalBlocks = image.width() / textWidth;
-  const int verticalBlocks = image.height() / textHeight;
+  const auto rampLength = m_asciiGlyphs.images.size();
+  const int textWidth  = m_asciiGlyphs.width;
+  const int textHeight = m_asciiGlyphs.height;
+  const int horizontalBlocks = image->width() / textWidth;
+  const int verticalBlocks = image->height() / textHeight;
 
-  std::vector<unsigned int> blocks(horizontalBlocks * verticalBlocks);
-  std::vector<std::pair<QColor,unsigned int>> blocksValue(horizontalBlocks * verticalBlocks);
-  std::iota(blocks.begin(), blocks.end(), 0);
+  const auto averages = AsciiArt::cellAverages(*image, QSize{textWidth, textHeight});
 
-  auto processBlock = [&](unsigned int &blockPos)
+  std::vector<std::pair<QRgb,unsigned int>> blocksValue(horizontalBlocks * verticalBlocks);
+  for(int blockPos = 0; blockPos < horizontalBlocks * verticalBlocks; ++blockPos)
   {
     const int charX = (blockPos % horizontalBlocks) * textWidth;
     const int charY = (blockPos / horizontalBlocks) * textHeight;
 
-    unsigned int value = 0;
-    int valid = 0;
-    for (int i = 0; i < textWidth; ++i)
+    const auto value = AsciiArt::rampIndex(averages[blockPos], rampLength);
+    blocksValue[blockPos] = std::pair<QRgb,unsigned int>{reinterpret_cast<const QRgb *>(image->constScanLine(charY))[charX], value};
+  }
+
+  // the source is not read anymore, it can be the destination.
+  uchar *bits = destination.bits();
+  const auto bytesPerLine = destination.bytesPerLine();
+  const int width = destination.width();
+
+  std::vector<int> lines(destination.height());
+  std::iota(lines.begin(), lines.end(), 0);
+
+  // every line tints the coverage of its row of glyphs with the color of each cell.
+  auto processLine = [&](int &y)
+  {
+    auto line = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+    const int blockRow = y / textHeight;
+    int x = 0;
+
+    if(blockRow < verticalBlocks)
     {
-      for (int j = 0; j < textHeight; ++j)
+      for(int block = 0; block < horizontalBlocks; ++block)
       {
-        auto rgb = image.pixel(charX + i, charY + j);
-        value += qGray(rgb);
-        ++valid;
+        const auto &blockValue = blocksValue[blockRow * horizontalBlocks + block];
+        const auto coverage = m_asciiGlyphs.images.at(blockValue.second).constScanLine(y % textHeight);
+        const auto color = blockValue.first;
+
+        for(int i = 0; i < textWidth; ++i, ++x)
+        {
+          const unsigned int alpha = coverage[i];
+          auto tint = [alpha](unsigned int channel)
+          {
+            const unsigned int t = channel * alpha + 0x80;
+            return (t + (t >> 8)) >> 8;
+          };
+          line[x] = qRgb(tint(qRed(color)), tint(qGreen(color)), tint(qBlue(color)));
+        }
       }
     }
-    value /= valid;
-    value = (value * (rampLength-1)) / 255;
-    blocksValue[blockPos] = std::pair<QColor,unsigned int>{QColor::fromRgb(image.pixel(charX, charY)), value};
+
+    std::fill(line + x, line + width, qRgb(0,0,0));
   };
   // Parallel execution
-  std::for_each(std::execution::par, blocks.begin(), blocks.end(), processBlock);
+  std::for_each(std::execution::par, lines.begin(), lines.end(), processLine);
+}
 
-  QPainter painter(&image);
-  painter.setFont(font);
-  painter.fillRect(image.rect(), Qt::black);
+//-----------------------------------------------------------------
+void CaptureDesktopThread::renderAsciiGlyphs()
+{
+  const auto ramp = RAMPS.at(m_ramp).value;
 
-  for(size_t i = 0; i < blocksValue.size(); ++i)
+  QFont font;
+  font.setBold(true);
+  font.setFixedPitch(true);
+  font.setPixelSize(m_rampCharSize);
+  const QFontMetrics metrics(font);
+
+  m_asciiGlyphs.ramp   = m_ramp;
+  m_asciiGlyphs.size   = m_rampCharSize;
+  m_asciiGlyphs.width  = metrics.boundingRect("A").width();
+  m_asciiGlyphs.height = metrics.height();
+  m_asciiGlyphs.images.clear();
+
+  for(const auto &character: ramp)
   {
-    const int charX = (i % horizontalBlocks) * textWidth;
-    const int charY = (i / horizontalBlocks) * textHeight;
-    const auto background = blocksValue[i].first;
-    painter.fillRect(charX, charY, textWidth, textHeight, Qt::black);
-    painter.setPen(background);
-    painter.drawText(charX, charY, QString(ramp.at(blocksValue[i].second)));
-  }
+    QImage glyph(m_asciiGlyphs.width, m_asciiGlyphs.height, QImage::Format_ARGB32_Premultiplied);
+    glyph.fill(Qt::transparent);
 
-  painter.end();
+    QPainter painter(&glyph);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(0, metrics.ascent(), QString(character));
+    painter.end();
+
+    m_asciiGlyphs.images << glyph.convertToFormat(QImage::Format_Alpha8);
+  }
 }
 
 //-----------------------------------------------------------------
-void CaptureDesktopThread::overlayPomodoro(QImage &image)
+void CaptureDesktopThread::renderStatsLayer()
 {
-	if (!m_pomodoro) return;
+	const int height = pomodoroOverlayHeight();
+	const auto tasks = m_pomodoro->getCompletedTasks();
 
-	static unsigned long total = 0;
-	const auto compositionMode = COMPOSITION_MODES_QT.at(static_cast<int>(m_statisticsMode));
+	// units are clipped to the panel, the extra pixel holds the right and bottom lines of the frame.
+	m_statsLayer = QImage(POMODORO_UNIT_MAX_WIDTH + 1, height + 1, QImage::Format_ARGB32_Premultiplied);
+	m_statsLayer.fill(Qt::transparent);
 
-	QPainter painter(&image);
-	painter.setCompositionMode(compositionMode);
+	QPainter painter(&m_statsLayer);
+	painter.setCompositionMode(COMPOSITION_MODES_QT.at(static_cast<int>(m_statisticsMode)));
 
-	QFont font = painter.font();
-	font.setBold(true);
-	const int height = pomodoroOverlayHeight();
 	QColor color = Qt::lightGray;
 	color.setAlphaF(0.33);
-	painter.fillRect(m_statsPosition.x(), m_statsPosition.y(), POMODORO_UNIT_MAX_WIDTH, height, color);
+	painter.fillRect(0, 0, POMODORO_UNIT_MAX_WIDTH, height, color);
 
 	if (m_drawFrame)
 	{
@@ -792,11 +991,11 @@ void CaptureDesktopThread::overlayPomodoro(QImage &image)
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
   	for (int i = 0; i < 5; ++i)
   	{
-    	poly.setPoint(0, m_statsPosition.x()+i, m_statsPosition.y()+i);
-    	poly.setPoint(1, m_statsPosition.x()+ POMODORO_UNIT_MAX_WIDTH-i, m_statsPosition.y()+i);
-    	poly.setPoint(2, m_statsPosition.x()+ POMODORO_UNIT_MAX_WIDTH-i, m_statsPosition.y()+ height-i);
-    	poly.setPoint(3, m_statsPosition.x()+i, m_statsPosition.y()+ height-i);
-    	poly.setPoint(4, m_statsPosition.x()+i, m_statsPosition.y()+i);
+    	poly.setPoint(0, i, i);
+    	poly.setPoint(1, POMODORO_UNIT_MAX_WIDTH-i, i);
+    	poly.setPoint(2, POMODORO_UNIT_MAX_WIDTH-i, height-i);
+    	poly.setPoint(3, i, height-i);
+    	poly.setPoint(4, i, i);
     	painter.drawConvexPolygon(poly);
   	}
 
@@ -806,21 +1005,21 @@ void CaptureDesktopThread::overlayPomodoro(QImage &image)
   	QFontMetrics metrics(serifFont);
   	int fontWidth = metrics.boundingRect(QString("Pomodoro")).width();
   	const int fontHeight = metrics.height();
-  	QPoint position = QPoint(m_statsPosition.x() + POMODORO_UNIT_MAX_WIDTH/2 - fontWidth/2 , (2*m_statsPosition.y()+height)/2 - fontHeight/2);
+  	QPoint position = QPoint(POMODORO_UNIT_MAX_WIDTH/2 - fontWidth/2 , height/2 - fontHeight/2);
   	painter.drawText(position, QString("Pomodoro"));
   	fontWidth = metrics.boundingRect(QString("Statistics")).width();
-  	position = QPoint(m_statsPosition.x() + POMODORO_UNIT_MAX_WIDTH/2 - fontWidth/2, position.y()+5 + fontHeight);
+  	position = QPoint(POMODORO_UNIT_MAX_WIDTH/2 - fontWidth/2, position.y()+5 + fontHeight);
   	painter.drawText(position, QString("Statistics"));
 	}
 	else
 	{
-		QPoint position = m_statsPosition;
+		QPoint position{0,0};
 		const auto completedPomodoros = m_pomodoro->completedPomodoros();
 		const auto pomodorosBeforeBreak = m_pomodoro->getPomodorosBeforeLongBreak();
 
 		for(unsigned int i = 1; i <= completedPomodoros; ++i)
 		{
-			drawPomodoroUnit(painter, Qt::red, position, m_pomodoro->getCompletedTasks()[i-1]);
+			drawPomodoroUnit(painter, Qt::red, position, tasks.value(i-1));
 			position.setY(position.y() + POMODORO_UNIT_HEIGHT);
 
 			const auto numLongBreaks = i / pomodorosBeforeBreak;
@@ -844,50 +1043,178 @@ void CaptureDesktopThread::overlayPomodoro(QImage &image)
 			}
 		}
 
-		QString text;
-		QTime zero;
-		const unsigned long mSec = m_pomodoro->elapsed();
-		switch(m_pomodoro->status())
-		{
-			case Pomodoro::Status::Stopped:
-				return;
-				break;
-			case Pomodoro::Status::Pomodoro:
-				color = Qt::red;
-				text = m_pomodoro->getTaskTitle();
-				total = zero.msecsTo(m_pomodoro->getPomodoroDuration());
-				break;
-			case Pomodoro::Status::ShortBreak:
-				color = Qt::blue;
-				text = QString("In A Short Break");
-				total = zero.msecsTo(m_pomodoro->getShortBreakDuration());
-				break;
-			case Pomodoro::Status::LongBreak:
-				color = Qt::green;
-				text = QString("In A Long Break");
-				total = zero.msecsTo(m_pomodoro->getLongBreakDuration());
-				break;
-			case Pomodoro::Status::Paused:
-				color = Qt::gray;
-				text = QString("Paused");
-				break;
-			default:
-				Q_ASSERT(false);
-				break;
-		}
-
-		const int pixels = static_cast<double>(mSec) / static_cast<double>(total) * POMODORO_UNIT_MAX_WIDTH;
-		drawPomodoroUnit(painter, color, position, text, pixels);
+		m_statsProgress = position;
 	}
 
+	// the current unit is painted with the state left by the completed ones.
+	m_statsOpacity = painter.opacity();
 	painter.end();
 }
 
 //-----------------------------------------------------------------
-void CaptureDesktopThread::overlayTime(QImage &baseImage)
+void CaptureDesktopThread::invalidateStatsOverlay()
 {
-  const auto timeRect = computeTimeOverlayRect(m_timeTextSize, m_timePosition);
-  const auto timeText = QDateTime::currentDateTime().time().toString("hh:mm:ss");
+	m_statsDirty = true;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::overlayPomodoro(QImage &image, const QPoint &position)
+{
+	if (!m_pomodoro) return;
+
+	if (m_statsDirty.exchange(false) || m_statsLayer.isNull())
+		renderStatsLayer();
+
+	const auto compositionMode = COMPOSITION_MODES_QT.at(static_cast<int>(m_statisticsMode));
+	const auto blended = Blend::drawImage(image, position, m_statsLayer, compositionMode);
+
+	QPainter painter(&image);
+	painter.setCompositionMode(compositionMode);
+	if (!blended) painter.drawImage(position, m_statsLayer);
+
+	if (m_drawFrame) return;
+
+	QColor color;
+	QString text;
+	int pixels = 0;
+	if (!pomodoroProgress(color, text, pixels)) return;
+
+	painter.setOpacity(m_statsOpacity);
+	drawPomodoroUnit(painter, color, position + m_statsProgress, text, pixels);
+
+	painter.end();
+}
+
+//-----------------------------------------------------------------
+bool CaptureDesktopThread::pomodoroProgress(QColor &color, QString &text, int &pixels)
+{
+	static unsigned long total = 0;
+
+	QTime zero;
+	const unsigned long mSec = m_pomodoro->elapsed();
+	switch(m_pomodoro->status())
+	{
+		case Pomodoro::Status::Stopped:
+			return false;
+			break;
+		case Pomodoro::Status::Pomodoro:
+			color = Qt::red;
+			text = m_pomodoro->getTaskTitle();
+			total = zero.msecsTo(m_pomodoro->getPomodoroDuration());
+			break;
+		case Pomodoro::Status::ShortBreak:
+			color = Qt::blue;
+			text = QString("In A Short Break");
+			total = zero.msecsTo(m_pomodoro->getShortBreakDuration());
+			break;
+		case Pomodoro::Status::LongBreak:
+			color = Qt::green;
+			text = QString("In A Long Break");
+			total = zero.msecsTo(m_pomodoro->getLongBreakDuration());
+			break;
+		case Pomodoro::Status::Paused:
+			color = Qt::gray;
+			text = QString("Paused");
+			break;
+		default:
+			Q_ASSERT(false);
+			break;
+	}
+
+	pixels = static_cast<double>(mSec) / static_cast<double>(total) * POMODORO_UNIT_MAX_WIDTH;
+	return true;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::updateStatisticsLayer()
+{
+	auto &layer = m_layers[static_cast<int>(LAYER::STATISTICS)];
+
+	// the progress grows a pixel every few seconds, the sprite is kept until then.
+	QColor color;
+	QString text;
+	int pixels = 0;
+	const auto running = !m_drawFrame && pomodoroProgress(color, text, pixels);
+	const auto key = running ? QString("%1 %2 %3").arg(color.rgba()).arg(pixels).arg(text) : QString();
+
+	if (m_statsDirty || layer.sprite.isNull() || layer.key != key)
+	{
+		QImage sprite(POMODORO_UNIT_MAX_WIDTH + 1, pomodoroOverlayHeight() + 1, QImage::Format_ARGB32_Premultiplied);
+		sprite.fill(Qt::transparent);
+		overlayPomodoro(sprite, QPoint{0,0});
+
+		layer.sprite = sprite;
+		layer.key = key;
+	}
+
+	layer.position = m_statsPosition;
+	layer.mode = m_statisticsMode;
+	layer.visible = true;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::renderTimeGlyphs()
+{
+  static const QString GLYPHS = "0123456789:";
+
+  QFont font;
+  font.setBold(true);
+  font.setPixelSize(m_timeTextSize);
+  const QFontMetrics metrics(font);
+
+  m_timeGlyphs.size   = m_timeTextSize;
+  m_timeGlyphs.color  = m_timeTextColor;
+  m_timeGlyphs.border = m_timeDrawBorder;
+  m_timeGlyphs.ascent = metrics.ascent();
+  m_timeGlyphs.height = metrics.height();
+
+  const qreal penWidth = m_timeTextSize*0.2;
+  m_timeGlyphs.margin = m_timeDrawBorder ? static_cast<int>(std::ceil(penWidth/2)) + 1 : 0;
+
+  const auto invertedColor = QColor{m_timeTextColor.red() ^ 0xFF, m_timeTextColor.green() ^ 0xFF, m_timeTextColor.blue() ^ 0xFF};
+  const QPen ipen(invertedColor, penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+  const int margin = m_timeGlyphs.margin;
+
+  for(int i = 0; i < TimeGlyphs::COUNT; ++i)
+  {
+    const auto glyph = QString(GLYPHS.at(i));
+    const int advance = metrics.horizontalAdvance(glyph);
+    const QPointF baseline{static_cast<qreal>(margin), static_cast<qreal>(margin + m_timeGlyphs.ascent)};
+
+    auto &image = m_timeGlyphs.images[i];
+    image = QImage(advance + 2*margin, m_timeGlyphs.height + 2*margin, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setRenderHint(QPainter::RenderHint::Antialiasing, true);
+
+    if(m_timeDrawBorder)
+    {
+      // the outline of the glyph replaces the traced mask of the rendered text.
+      QPainterPath path;
+      path.addText(baseline, font, glyph);
+      painter.strokePath(path, ipen);
+    }
+
+    painter.setPen(QColor{m_timeTextColor});
+    painter.setFont(font);
+    painter.drawText(baseline, glyph);
+    painter.end();
+
+    m_timeGlyphs.advances[i] = advance;
+  }
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::overlayTime(QImage &baseImage, const QPoint &position, const QString &timeText)
+{
+  const auto timeRect = computeTimeOverlayRect(m_timeTextSize, position);
+
+  if(m_timeGlyphs.size != m_timeTextSize || m_timeGlyphs.color != m_timeTextColor || m_timeGlyphs.border != m_timeDrawBorder)
+  {
+    renderTimeGlyphs();
+  }
 
 	QPainter painter;
   painter.begin(&baseImage);
@@ -900,38 +1227,24 @@ void CaptureDesktopThread::overlayTime(QImage &baseImage)
   }
 
 	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-  painter.setRenderHint(QPainter::RenderHint::Antialiasing, true);
-
-	QFont font = painter.font();
-	font.setBold(true);
-  font.setPixelSize(m_timeTextSize);
-  painter.setFont(font);
 
-  if(m_timeDrawBorder)
+  // the text is centered in the rect, the same as Qt::AlignCenter.
+  int indexes[8];
+  int textWidth = 0;
+  for(int i = 0; i < timeText.length() && i < 8; ++i)
   {
-    const auto invertedColor = QColor{m_timeTextColor.red() ^ 0xFF, m_timeTextColor.green() ^ 0xFF, m_timeTextColor.blue() ^ 0xFF};
-    QPixmap tempPix(QSize{timeRect.width(), timeRect.height()});
-    tempPix.fill(Qt::transparent);
-    QPainter newPainter(&tempPix);
-    newPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    newPainter.setPen(QColor{m_timeTextColor});
-    newPainter.setFont(font);
-    newPainter.drawText(tempPix.rect(), Qt::AlignCenter, timeText);
-    // constructing temporal object only to get path for border.
-    QGraphicsPixmapItem tempItem(tempPix);
-    tempItem.setShapeMode(QGraphicsPixmapItem::MaskShape);
-    const auto path = tempItem.shape();
-
-    QPen ipen(invertedColor, m_timeTextSize*0.2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
-    newPainter.setPen(ipen);
-    newPainter.drawPath(path);
-    newPainter.end();
-
-    painter.drawImage(timeRect.topLeft(), tempPix.toImage());
+    const auto character = timeText.at(i);
+    indexes[i] = (character == QChar(':')) ? 10 : character.digitValue();
+    textWidth += m_timeGlyphs.advances[indexes[i]];
   }
 
-  painter.setPen(QColor{m_timeTextColor});
-  painter.drawText(timeRect, Qt::AlignCenter, timeText);
+  int x = timeRect.left() + (timeRect.width() - textWidth)/2 - m_timeGlyphs.margin;
+  const int y = timeRect.top() + (timeRect.height() - m_timeGlyphs.height)/2 - m_timeGlyphs.margin;
+  for(int i = 0; i < timeText.length() && i < 8; ++i)
+  {
+    painter.drawImage(x, y, m_timeGlyphs.images[indexes[i]]);
+    x += m_timeGlyphs.advances[indexes[i]];
+  }
 
   if (m_drawFrame)
 	{
@@ -939,11 +1252,11 @@ void CaptureDesktopThread::overlayTime(QImage &baseImage)
     painter.setPen(QColor(Qt::green));
   	for (int i = 0; i < 5; ++i)
   	{
-    	poly.setPoint(0, m_timePosition.x()+i, m_timePosition.y()+i);
-    	poly.setPoint(1, m_timePosition.x()+ timeRect.width()-i, m_timePosition.y()+i);
-    	poly.setPoint(2, m_timePosition.x()+ timeRect.width()-i, m_timePosition.y()+ timeRect.height()-i);
-    	poly.setPoint(3, m_timePosition.x()+i, m_timePosition.y()+ timeRect.height()-i);
-    	poly.setPoint(4, m_timePosition.x()+i, m_timePosition.y()+i);
+    	poly.setPoint(0, position.x()+i, position.y()+i);
+    	poly.setPoint(1, position.x()+ timeRect.width()-i, position.y()+i);
+    	poly.setPoint(2, position.x()+ timeRect.width()-i, position.y()+ timeRect.height()-i);
+    	poly.setPoint(3, position.x()+i, position.y()+ timeRect.height()-i);
+    	poly.setPoint(4, position.x()+i, position.y()+i);
     	painter.drawConvexPolygon(poly);
   	}
   }
@@ -951,6 +1264,65 @@ void CaptureDesktopThread::overlayTime(QImage &baseImage)
   painter.end();
 }
 
+//-----------------------------------------------------------------
+void CaptureDesktopThread::updateTimeLayer()
+{
+  auto &layer = m_layers[static_cast<int>(LAYER::TIME)];
+
+  // the text changes once per second, the captures in between reuse the sprite.
+  const auto timeText = QDateTime::currentDateTime().time().toString("hh:mm:ss");
+  const auto key = QString("%1 %2 %3 %4 %5 %6").arg(timeText)
+                                               .arg(m_timeTextSize)
+                                               .arg(m_timeTextColor.rgba())
+                                               .arg(static_cast<int>(m_timeDrawBorder))
+                                               .arg(static_cast<int>(m_timeBackground))
+                                               .arg(static_cast<int>(m_drawFrame));
+
+  if(layer.sprite.isNull() || layer.key != key)
+  {
+    const auto timeRect = computeTimeOverlayRect(m_timeTextSize, QPoint{0,0});
+    QImage sprite(timeRect.width() + 1, timeRect.height() + 1, QImage::Format_ARGB32_Premultiplied);
+    sprite.fill(Qt::transparent);
+    overlayTime(sprite, QPoint{0,0}, timeText);
+
+    layer.sprite = sprite;
+    layer.key = key;
+  }
+
+  layer.position = m_timePosition;
+  layer.mode = COMPOSITION_MODE::COPY;
+  layer.visible = true;
+}
+
+//-----------------------------------------------------------------
+void CaptureDesktopThread::composeLayers(QImage &baseImage, QList<QRect> &regions, QList<I420Overlay::Sprite> &sprites)
+{
+  for(const auto &layer: m_layers)
+  {
+    if(!layer.visible) continue;
+
+    regions << layer.bounds();
+
+    if(m_overlaySprites && layer.mode == COMPOSITION_MODE::COPY)
+    {
+      sprites << I420Overlay::Sprite{layer.sprite, layer.position};
+      continue;
+    }
+
+    const auto compositionMode = COMPOSITION_MODES_QT.at(static_cast<int>(layer.mode));
+    if(!Blend::drawImage(baseImage, layer.position, layer.sprite, compositionMode))
+    {
+      QPainter painter(&baseImage);
+      painter.setCompositionMode(compositionMode);
+      painter.drawImage(layer.position, layer.sprite);
+      painter.end();
+    }
+  }
+
+  if (m_drawFrame && m_layers[static_cast<int>(LAYER::CAMERA)].visible)
+    drawCameraImageFrame(baseImage);
+}
+
 //-----------------------------------------------------------------
 void CaptureDesktopThread::setCameraOverlayCompositionMode(COMPOSITION_MODE mode)
 {
@@ -961,38 +1333,58 @@ void CaptureDesktopThread::setCameraOverlayCompositionMode(COMPOSITION_MODE mode
 void CaptureDesktopThread::setPaintFrame(bool status)
 {
 	m_drawFrame = status;
+	m_statsDirty = true;
 }
 
 //-----------------------------------------------------------------
 void CaptureDesktopThread::takeScreenshot()
 {
 	// capture desktop
+  const auto timestamp = m_clock.elapsed();
   auto desktopPixmap = QApplication::screens().first()->grabWindow(0, m_geometry.x(), m_geometry.y(), m_geometry.width(), m_geometry.height());
 
-	if(m_pomodoro || m_cameraEnabled || m_timeOverlayEnabled)
+  QList<QRect> regions;
+  QList<I420Overlay::Sprite> sprites;
+  const auto window = activeWindowGeometry();
+  if(!window.isEmpty())
+    regions << window;
+
+	if(m_cameraEnabled || (m_textOverlays && (m_pomodoro || m_timeOverlayEnabled)))
 	{
 	  auto desktopImage = desktopPixmap.toImage();
 
-	  // capture camera & composite
+	  for(auto &layer: m_layers)
+	    layer.visible = false;
+
+	  // capture camera
 	  if (m_cameraEnabled && m_camera.isOpened())
 	  {
 	    while (!m_camera.read(m_frame))
 	      usleep(100);
 
-      auto cameraImage = MatToQImage(m_frame);
+      if(m_normalizeCamera)
+        normalizeBrightness(m_frame, m_frame);
 
-      overlayCameraImage(desktopImage, cameraImage);
+      // the only copy of the frame, the next read reuses its buffer.
+      auto cameraImage = CameraImage::MatToQImage(m_frame).convertToFormat(QImage::Format_RGB32);
+
+      overlayCameraImage(cameraImage);
 	  }
 
-	  if(m_pomodoro)
-	    overlayPomodoro(desktopImage);
+	  if(m_pomodoro && m_textOverlays)
+	    updateStatisticsLayer();
+
+    if(m_timeOverlayEnabled && m_textOverlays)
+      updateTimeLayer();
 
-    if(m_timeOverlayEnabled)
-      overlayTime(desktopImage);
+	  composeLayers(desktopImage, regions, sprites);
 
 	  desktopPixmap = QPixmap::fromImage(desktopImage);
 	}
 
   QMutexLocker lock(&m_mutex);
   m_image = desktopPixmap;
+  m_imageTimestamp = timestamp;
+  m_regions = regions;
+  m_sprites = sprites;
 }
@@ -21,11 +21,14 @@
 #define CAPTURE_DESKTOP_THREAD_H_
 
 // C++
+#include <array>
+#include <atomic>
 #include <memory>
 
 // Project
 #include <Resolutions.h>
 #include <Pomodoro.h>
+#include <I420Overlay.h>
 
 // OpenCV
 #include <opencv2/highgui/highgui.hpp>
@@ -36,6 +39,7 @@
 #include <QMutex>
 #include <QPainter>
 #include <QWaitCondition>
+#include <QElapsedTimer>
 
 
 // dLib
@@ -239,6 +243,17 @@ class CaptureDesktopThread
      */
 		QPixmap *getImage();
 
+    /** \brief Returns the time of the capture of the final composed image in milliseconds of a monotonic clock.
+     *
+     */
+		qint64 getImageTimestamp();
+
+    /** \brief Returns the areas of the final composed image that deserve more quality: the foreground window
+     *  and the overlays painted over the desktop.
+     *
+     */
+		QList<QRect> getRegionsOfInterest();
+
     /** \brief Takes a picture of the desktop.
      *
      */
@@ -270,12 +285,50 @@ class CaptureDesktopThread
 		 */
 		void setTrackFaceSmooth(bool enabled);
 
+		/** \brief Enables/disables the composition of the camera picture over the desktop. When enabled the
+		 *  camera picture is not composited and can be retrieved with getCameraImage().
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setCameraSeparateTrack(bool enabled);
+
+		/** \brief Returns the last camera picture if the camera is not composited over the desktop.
+		 *
+		 */
+		QImage getCameraImage();
+
+		/** \brief Enables/disables the overlays as sprites. When enabled the overlays with the SourceOver
+		 *  composition are not painted over the desktop and can be retrieved with getOverlaySprites().
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setOverlaySprites(bool enabled);
+
+		/** \brief Returns the overlays of the last capture that were not painted over the desktop.
+		 *
+		 */
+		QList<I420Overlay::Sprite> getOverlaySprites();
+
+		/** \brief Enables/disables the painting of the time and pomodoro overlays. When disabled the
+		 *  texts are written to the video as a subtitles track instead.
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setTextOverlaysEnabled(bool enabled);
+
 		/** \brief Enable/disable the conversion of the camera picture to ASCII art.
 		 * \param[in] enabled boolean value.
 		 *
 		 */
 		void setCameraAsASCII(bool enabled);
 
+		/** \brief Enable/disable the brightness normalization of the camera picture. The image
+		 *  used for the face detection is always normalized.
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setCameraNormalized(bool enabled);
+
 		/** \brief Sets the time overlay text size. 
 		 * \param[in] value Pixel size of time overlay font. 
 		 *
@@ -326,14 +379,91 @@ class CaptureDesktopThread
 
 		static const QList<CaptureDesktopThread::Ramp> RAMPS;
 
+		/** \struct OverlayLayer
+		 * \brief Overlay composited over the desktop. The sprite is only rendered again when the
+		 *  description of its contents changes.
+		 *
+		 */
+		struct OverlayLayer
+		{
+			QImage           sprite;   /** rendered overlay.                                      */
+			QPoint           position; /** top left corner of the sprite in the desktop.          */
+			COMPOSITION_MODE mode;     /** composition of the sprite over the desktop.            */
+			QString          key;      /** description of the contents of the sprite.             */
+			bool             visible;  /** true if the layer is composited in the current capture. */
+
+			OverlayLayer()
+			: mode{COMPOSITION_MODE::COPY}, visible{false}{};
+
+			QRect bounds() const
+			{ return QRect{position, sprite.size()}; }
+		};
+
+		/** \class LAYER
+		 * \brief Overlay layers in z-order, the first one is composited first.
+		 *
+		 */
+		enum class LAYER : char
+		{
+			CAMERA = 0,
+			STATISTICS,
+			TIME,
+			COUNT
+		};
+
+		/** \struct TimeGlyphs
+		 * \brief Pre-rendered glyphs of the time overlay for a given size, color and border.
+		 *
+		 */
+		struct TimeGlyphs
+		{
+			static constexpr int COUNT = 11; /** digits and the colon. */
+
+			int    size;                     /** pixel size of the font.                              */
+			QColor color;                    /** color of the text.                                   */
+			bool   border;                   /** true if the glyphs have the border stroked.          */
+			int    margin;                   /** margin around the glyph for the border, in pixels.   */
+			int    ascent;                   /** font ascent in pixels.                               */
+			int    height;                   /** font height in pixels.                               */
+			int    advances[COUNT];          /** horizontal advance of each glyph.                    */
+			QImage images[COUNT];            /** glyph images, with the margin on every side.         */
+
+			TimeGlyphs()
+			: size{-1}, border{false}, margin{0}, ascent{0}, height{0}, advances{}{};
+		};
+
+		/** \struct AsciiGlyphs
+		 * \brief Pre-rendered coverage of the characters of a ramp for a given character size.
+		 *
+		 */
+		struct AsciiGlyphs
+		{
+			int           ramp;              /** index of the ramp of the glyphs.                     */
+			int           size;              /** pixel size of the font.                              */
+			int           width;             /** width of the character cell in pixels.               */
+			int           height;            /** height of the character cell in pixels.              */
+			QList<QImage> images;            /** glyph coverage in Alpha8, one per ramp character.    */
+
+			AsciiGlyphs()
+			: ramp{-1}, size{-1}, width{0}, height{0}{};
+		};
+
 		static constexpr int POMODORO_UNIT_MAX_WIDTH = 250;
 		static constexpr int POMODORO_UNIT_HEIGHT = 15;
 		static constexpr int POMODORO_UNIT_MARGIN = 2;
 		static constexpr float POMODORO_UNIT_OPACITY = 0.8;
+		static constexpr int MASK_MIN_LEVEL_SIZE = 32; /** minimum size in pixels of the smallest mask level. */
+		static constexpr int CAMERA_PROXY_STEP = 4;    /** subsampling step of the brightness estimate proxy.  */
 
 	signals:
 		void imageAvailable();
 
+	private slots:
+		/** \brief Marks the cached statistics overlay to be rendered again with the next capture.
+		 *
+		 */
+		void invalidateStatsOverlay();
+
 	private:
 		/** \brief Computes the position of the top left corner given the size of the area and
 		 *         the POSITION to put it.
@@ -343,24 +473,74 @@ class CaptureDesktopThread
 		 */
 		QPoint computePosition(const POSITION position, const QRect &area);
 
-    /** \brief Overlays the camera image over the desktop captured image.
-     * \param[inout] baseImage captured desktop image.
+    /** \brief Processes the camera picture and sets it as the camera layer, or keeps it apart if the camera
+     *  is not composited.
      * \param[in] overlayImage camera picture.
      *
      */
-		void overlayCameraImage(QImage &baseImage, QImage &overlayImage);
+		void overlayCameraImage(QImage &overlayImage);
 
-    /** \brief Overlays the pomodoro statistics over the desktop captured image.
+    /** \brief Overlays the pomodoro statistics over the desktop captured image. The completed units
+     *  come from the cached layer, only the progress of the current unit is painted every frame.
      * \param[inout] baseImage captured desktop image.
+     * \param[in] position top left corner of the statistics in the image.
+     *
+     */
+		void overlayPomodoro(QImage &baseImage, const QPoint &position);
+
+    /** \brief Computes the progress of the current pomodoro unit. Returns false if the pomodoro is stopped.
+     * \param[out] color color of the unit.
+     * \param[out] text text of the unit.
+     * \param[out] pixels width in pixels of the elapsed part of the unit.
      *
      */
-		void overlayPomodoro(QImage &baseImage);
+		bool pomodoroProgress(QColor &color, QString &text, int &pixels);
+
+    /** \brief Renders the static part of the pomodoro statistics (background, completed units or the
+     *  positioning frame) in the cached layer.
+     *
+     */
+		void renderStatsLayer();
 
 		/** \brief Overlays the time over the desktop captured image. 
      * \param[inout] baseImage captured desktop image.		
+     * \param[in] position top left corner of the time in the image.
+     * \param[in] timeText text of the time.
 		 *
 		 */
-		void overlayTime(QImage &baseImage);
+		void overlayTime(QImage &baseImage, const QPoint &position, const QString &timeText);
+
+    /** \brief Updates the statistics layer, rendered again only when the completed units or the drawn
+     *  progress change.
+     *
+     */
+		void updateStatisticsLayer();
+
+    /** \brief Updates the time layer, rendered again only when the time text or its settings change.
+     *
+     */
+		void updateTimeLayer();
+
+    /** \brief Composites the visible layers over the desktop image in z-order. The layers with SourceOver
+     *  composition are added to the sprites instead if those are enabled.
+     * \param[inout] baseImage captured desktop image.
+     * \param[inout] regions regions of interest, the bounds of the layers are added.
+     * \param[inout] sprites overlay sprites not painted over the desktop.
+     *
+     */
+		void composeLayers(QImage &baseImage, QList<QRect> &regions, QList<I420Overlay::Sprite> &sprites);
+
+		/** \brief Renders the glyphs of the time overlay with the current size, color and border
+		 *  settings, with the border already stroked.
+		 *
+		 */
+		void renderTimeGlyphs();
+
+		/** \brief Renders the coverage of the characters of the current ramp with the current
+		 *  character size, each one in a cell of the ASCII art image.
+		 *
+		 */
+		void renderAsciiGlyphs();
 
     /** \brief Draws a single pomodoro unit.
      * \param[inout] painter painter object reference.
@@ -379,6 +559,12 @@ class CaptureDesktopThread
 		 */
 		void drawMask(QImage &cameraImage, dlib::full_object_detection shapes);
 
+		/** \brief Decodes the mask and builds its levels, each one half the size of the previous one.
+		 * \param[in] maskIndex index of the mask in MASKS.
+		 *
+		 */
+		void loadMask(const int maskIndex);
+
 		/** \brief Draws the positioning frame around the camra image.
      * \param[in] cameraImage camera image.
 		 *
@@ -397,11 +583,11 @@ class CaptureDesktopThread
 		 */
 		int pomodoroOverlayHeight();
 
-    /** \brief Converts a MAT image from OpenCV to a Qt QImage.
-     * \param[in] mat reference to a OpenCV mat image.
-     *
-     */
-		QImage MatToQImage(const cv::Mat& mat);
+		/** \brief Returns the geometry of the foreground window relative to the captured area, or an empty
+		 *  rectangle if it can't be obtained in this platform.
+		 *
+		 */
+		QRect activeWindowGeometry() const;
 
 		/** \brief Converts the given image into an ASCII image.
 		 * \param[in/out] image QImage reference.
@@ -415,16 +601,38 @@ class CaptureDesktopThread
 		 */
 		void imageToASCII(QPixmap &image);
 
+		/** \brief Writes the ASCII art of the source image in the destination image.
+		 * \param[in] source image to convert, converted to RGB32 if not in a 32 bits format.
+		 * \param[out] destination image of the same size in a 32 bits format, can be the source.
+		 *
+		 */
+		void imageToASCII(const QImage &source, QImage &destination);
+
+		/** \brief Stretches the brightness of the source frame the same as cv::normalize() with
+		 *  NORM_MINMAX to the [128 - mean luma, 255] range. The mean luma and the extremes are
+		 *  estimated on a subsampled proxy and the stretch applied with a fixed point look up table.
+		 * \param[in] source BGR camera frame.
+		 * \param[out] destination normalized frame, can be the source.
+		 *
+		 */
+		void normalizeBrightness(const cv::Mat &source, cv::Mat &destination);
+
 		bool             m_aborted;              /** true if the thread has been aborted.                          */
 		bool             m_paused;               /** true to stop capturing.                                       */
 		QMutex           m_mutex;                /** thread mutex                                                  */
 		QWaitCondition   m_pauseWaitCondition;   /** thread pause condition                                        */
 
 		QPixmap          m_image;                /** final image after composition.                                */
+		QElapsedTimer    m_clock;                /** monotonic clock of the captures.                              */
+		qint64           m_imageTimestamp;       /** capture time of the final image in milliseconds.              */
+		QList<QRect>     m_regions;              /** regions of interest of the final image.                       */
 		QRect            m_geometry;             /** geometry of the capture area                                  */
 		Resolution       m_cameraResolution;     /** camera resolution                                             */
 		cv::VideoCapture m_camera;               /** opencv camera                                                 */
 		cv::Mat          m_frame;                /** opencv frame.                                                 */
+		cv::Mat          m_detectorFrame;        /** normalized frame for the face detection.                      */
+		cv::Mat          m_cameraProxy;          /** subsampled frame for the brightness estimate.                 */
+		bool             m_normalizeCamera;      /** true to normalize the brightness of the camera picture.       */
 		bool             m_cameraEnabled;        /** true if camera capture is enabled.                            */
 		bool             m_timeOverlayEnabled;   /** true if time overaly is enabled.                              */
 		QPoint           m_cameraPosition;       /** position of the camera overlay                                */
@@ -434,17 +642,32 @@ class CaptureDesktopThread
 		COMPOSITION_MODE m_statisticsMode;       /** composition mode for the statistics overlay.                  */
 		bool             m_drawFrame;            /** true to paint a frame of the overlayed camera and statistics. */
 		MASK             m_mask;                 /** mask to paint in the camera image.                            */
+		int              m_maskLoaded;           /** index of the mask in the levels, -1 if none.                  */
+		QList<QImage>    m_maskLevels;           /** decoded mask in premultiplied ARGB32, halved at every level.  */
 		bool             m_trackFace;            /** true to track and center the face in the camera picture.      */
 		bool             m_trackFaceSmooth;      /** true to smooth face coordinates and false otherwise.          */
 		bool             m_ASCII_Art;            /** true to convert the camera image to ASCII art.                */
+		bool             m_cameraSeparate;       /** true to keep the camera image apart from the desktop image.   */
+		QImage           m_cameraImage;          /** last camera image when not composited.                        */
+		bool             m_overlaySprites;       /** true to keep the SourceOver overlays apart as sprites.        */
+		QList<I420Overlay::Sprite> m_sprites;    /** overlays of the last capture not painted over the desktop.    */
+		bool             m_textOverlays;         /** true to paint the time and pomodoro overlays.                 */
 		int              m_ramp;                 /** index of the character ramp used in the ASCII art.            */
 		int              m_rampCharSize;         /** Qt font size of the characters used in the ramp.              */
+		AsciiGlyphs      m_asciiGlyphs;          /** glyphs atlas of the ASCII art image.                          */
 		int              m_timeTextSize;         /** Pixel size of Qt font used in time overlay text.              */
 		bool             m_timeDrawBorder;       /** true to draw the text border in the time overlay.             */
 		bool             m_timeBackground;       /** true to draw the background in the time overlay.              */
 		QColor           m_timeTextColor;        /** color of the text in the time overlay.                        */
+		TimeGlyphs       m_timeGlyphs;           /** glyphs atlas of the time overlay.                             */
 
 		std::shared_ptr<Pomodoro> m_pomodoro;    /** pomodoro shared pointer */
+		QImage            m_statsLayer;          /** cached static part of the statistics overlay.          */
+		QPoint            m_statsProgress;       /** position of the current unit in the statistics layer. */
+		qreal             m_statsOpacity;        /** painter opacity of the current unit.                  */
+		std::atomic<bool> m_statsDirty;          /** true if the statistics layer must be rendered again.   */
+
+		std::array<OverlayLayer, static_cast<size_t>(LAYER::COUNT)> m_layers; /** overlay layers in z-order. */
 
 		dlib::frontal_face_detector m_faceDetector; /** dlib face detector. */
 		dlib::shape_predictor       m_faceShape;    /** dlib face poser.    */
@@ -0,0 +1,95 @@
+/*
+    File: Crc32.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <Crc32.h>
+
+// C++
+#include <string.h>
+
+namespace
+{
+  /** \struct Tables
+   * \brief Slicing-by-8 tables, the first one is the byte-wise table.
+   */
+  struct Tables
+  {
+    quint32 values[8][256];
+  };
+
+  /** \brief Returns the tables of the reflected polynomial 0xEDB88320.
+   *
+   */
+  constexpr Tables createTables()
+  {
+    Tables tables{};
+    for(quint32 i = 0; i < 256; ++i)
+    {
+      quint32 value = i;
+      for(int bit = 0; bit < 8; ++bit)
+      {
+        value = (value >> 1) ^ ((value & 1) ? 0xEDB88320 : 0);
+      }
+      tables.values[0][i] = value;
+    }
+
+    for(int slice = 1; slice < 8; ++slice)
+    {
+      for(int i = 0; i < 256; ++i)
+      {
+        const auto previous = tables.values[slice - 1][i];
+        tables.values[slice][i] = (previous >> 8) ^ tables.values[0][previous & 0xFF];
+      }
+    }
+
+    return tables;
+  }
+
+  constexpr Tables TABLES = createTables();
+}
+
+//------------------------------------------------------------------
+quint32 crc32(const void *data, quint64 length, const quint32 crc)
+{
+  const auto &t = TABLES.values;
+  auto bytes = static_cast<const uchar *>(data);
+  quint32 value = ~crc;
+
+  // the words are read in little endian, the byte order of the supported platforms.
+  while(length >= 8)
+  {
+    quint32 low, high;
+    ::memcpy(&low, bytes, sizeof(low));
+    ::memcpy(&high, bytes + 4, sizeof(high));
+    low ^= value;
+
+    value = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+            t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+
+    bytes  += 8;
+    length -= 8;
+  }
+
+  while(length-- > 0)
+  {
+    value = (value >> 8) ^ t[0][(value ^ *bytes++) & 0xFF];
+  }
+
+  return ~value;
+}
@@ -0,0 +1,35 @@
+/*
+    File: Crc32.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+// Qt
+#include <QtGlobal>
+
+/** \brief Returns the CRC-32 (ISO 3309, the one of zlib and the Matroska CRC-32 element) of the data.
+ *  Uses slicing-by-8 tables, eight bytes are processed per iteration.
+ * \param[in] data raw pointer of the data.
+ * \param[in] length length of the data in bytes.
+ * \param[in] crc CRC-32 of the previous data when computed in several parts, 0 otherwise.
+ *
+ */
+quint32 crc32(const void *data, quint64 length, const quint32 crc = 0);
+
+#endif // CRC32_H_
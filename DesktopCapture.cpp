@@ -41,6 +41,10 @@
 #include <QInputDialog>
 #include <QColorDialog>
 #include <QFileDialog>
+#include <QFile>
+
+// C++
+#include <algorithm>
 
 // TEST & TIME
 
@@ -65,6 +69,10 @@ DesktopCapture::DesktopCapture()
 , m_started         {false}
 , m_statisticsDialog{nullptr}
 , m_paused          {false}
+, m_clockTrack      {0}
+, m_pomodoroTrack   {0}
+, m_rotationPending {false}
+, m_pomodoroNumber  {0}
 , m_menuPause       {nullptr}
 , m_menuShowStats   {nullptr}
 , m_menuStopCapture {nullptr}
@@ -101,7 +109,10 @@ DesktopCapture::~DesktopCapture()
 	if (m_captureThread)
 	{
 		if(m_started)
+		{
+			waitVideoFileClose();
 			m_vp8_interface = nullptr;
+		}
 
 		m_captureThread->abort();
 		m_captureThread->resume();
@@ -805,6 +816,7 @@ void DesktopCapture::setupCaptureThread()
 	m_captureThread->setRamp(m_rampCombo->currentIndex());
 	m_captureThread->setRampCharSize(m_rampCharacterSize->value());
 	m_captureThread->setCameraAsASCII(m_ASCIIart->isChecked());
+	m_captureThread->setCameraNormalized(m_config.cameraNormalizeBrightness);
 	m_captureThread->setCameraEnabled(m_config.cameraEnabled);
 
 	if(m_cameraPositionComboBox->currentIndex() != 0)
@@ -1154,6 +1166,15 @@ void DesktopCapture::onStartButtonPressed()
 		if (!m_captureThread->isPaused())
 			m_captureThread->pause();
 
+		// the camera goes to its own video track instead of being composited.
+		m_captureThread->setCameraSeparateTrack(m_videoRadioButton->isChecked() && m_cameraEnabled->isChecked() && m_config.cameraSeparateTrack);
+
+		// the time and pomodoro texts go to subtitles tracks instead of being painted.
+		m_captureThread->setTextOverlaysEnabled(!m_videoRadioButton->isChecked() || !m_config.captureTextTrack);
+
+		// the overlays are blended by the encoder after scaling the desktop.
+		m_captureThread->setOverlaySprites(m_videoRadioButton->isChecked() && m_config.captureVideoScaledOverlays);
+
 		const auto time = m_screenshotTime->time();
 		const int ms = time.second() * 1000 + time.minute() * 1000 * 60 + time.hour() * 60 * 60 * 1000 + time.msec();
 
@@ -1198,6 +1219,9 @@ void DesktopCapture::onStartButtonPressed()
 		connect(m_pomodoro.get(), SIGNAL(sessionEnded()),
 		        this,             SLOT(trayMessage()), Qt::DirectConnection);
 
+		if (m_captureGroupBox->isChecked() && m_videoRadioButton->isChecked())
+			connectChapterSignals(true);
+
 		m_pomodoro->start();
 	}
 
@@ -1247,16 +1271,21 @@ void DesktopCapture::capture()
 			saveCapture(pixmap);
 		else
 		{
-			if (m_secuentialNumber == 0)
-			{
-				const auto fileName = this->m_dirEditLabel->text() + QString("\\DesktopCapture_") + QDateTime::currentDateTime().toString("dd_MM_yyyy") + QString(".webm");
-				const auto desktopGeometry = captureGeometry();
+			// the new file starts with a keyframe, the capture goes on while the previous one is finished.
+			if (m_secuentialNumber == 0 || videoRotationNeeded())
+				createVideoInterface();
 
-				m_vp8_interface = std::make_shared<VPX_Interface>(fileName, desktopGeometry.height(), desktopGeometry.width(), m_fps->value(), m_scale);
-			}
+			updateTextTracks();
+
+			if (m_config.captureVideoRegionsOfInterest)
+				m_vp8_interface->setRegionsOfInterest(m_captureThread->getRegionsOfInterest(), m_config.captureVideoBackgroundQuantizer);
+
+			if (m_config.captureVideoScaledOverlays)
+				m_vp8_interface->setOverlays(m_captureThread->getOverlaySprites());
 
 			auto image = pixmap->toImage().convertToFormat(QImage::Format_RGB32);
-			m_vp8_interface->encodeFrame(&image);
+			const auto cameraImage = m_captureThread->getCameraImage();
+			m_vp8_interface->encodeFrame(&image, cameraImage.isNull() ? nullptr : &cameraImage, m_captureThread->getImageTimestamp());
 		}
 	}
 
@@ -1512,6 +1541,7 @@ void DesktopCapture::stopCapture()
 	             this,             SLOT(trayMessage()));
 	  disconnect(m_pomodoro.get(), SIGNAL(sessionEnded()),
 	             this,             SLOT(trayMessage()));
+	  connectChapterSignals(false);
 		m_pomodoroTask->setText(m_pomodoro->getTaskTitle());
 		m_pomodoro->stop();
 		m_pomodoro->clear();
@@ -1520,9 +1550,18 @@ void DesktopCapture::stopCapture()
 	if (m_captureThread && m_captureGroupBox->isChecked())
 	{
 		if(m_videoRadioButton->isChecked())
+		{
+			waitVideoFileClose();
 			m_vp8_interface = nullptr;
+		}
 
 		m_secuentialNumber = 0;
+		m_chapterTitle.clear();
+		m_pomodoroNumber = 0;
+		m_clockTrack = m_pomodoroTrack = 0;
+		m_captureThread->setCameraSeparateTrack(false);
+		m_captureThread->setTextOverlaysEnabled(true);
+		m_captureThread->setOverlaySprites(false);
 		m_captureThread->resume();
 	}
 
@@ -1768,3 +1807,224 @@ void DesktopCapture::onScaleIndexChanged(int value)
 
 	m_config.captureScale = value;
 }
+
+//-----------------------------------------------------------------
+void DesktopCapture::connectChapterSignals(bool enabled)
+{
+	const QList<QPair<const char *, const char *>> connections = { { SIGNAL(beginPomodoro()),   SLOT(onPomodoroBegin())   },
+	                                                               { SIGNAL(beginShortBreak()), SLOT(onShortBreakBegin()) },
+	                                                               { SIGNAL(beginLongBreak()),  SLOT(onLongBreakBegin())  },
+	                                                               { SIGNAL(pomodoroEnded()),   SLOT(onPomodoroEnd())     },
+	                                                               { SIGNAL(sessionEnded()),    SLOT(onPomodoroEnd())     },
+	                                                               { SIGNAL(shortBreakEnded()), SLOT(onBreakEnd())        },
+	                                                               { SIGNAL(longBreakEnded()),  SLOT(onBreakEnd())        } };
+
+	for (const auto &connection: connections)
+	{
+		if (enabled)
+			connect(m_pomodoro.get(), connection.first, this, connection.second, Qt::UniqueConnection);
+		else
+			disconnect(m_pomodoro.get(), connection.first, this, connection.second);
+	}
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::markChapter(const QString &title)
+{
+	m_chapterTitle = title;
+
+	if (m_vp8_interface)
+		m_vp8_interface->markChapter(title);
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::onPomodoroBegin()
+{
+	m_rotationPending = true;
+
+	const auto number = m_pomodoro->completedPomodoros() + 1;
+	m_pomodoroNumber = number;
+	if (m_vp8_interface)
+		m_vp8_interface->setPomodoro(number);
+
+	markChapter(tr("Pomodoro %1 - %2").arg(number).arg(m_pomodoro->getTaskTitle()));
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::onShortBreakBegin()
+{
+	markChapter(tr("Short break"));
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::onLongBreakBegin()
+{
+	markChapter(tr("Long break"));
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::onPomodoroEnd()
+{
+	// the task can change during the pomodoro, the completed task has the final title.
+	const auto tasks = m_pomodoro->getCompletedTasks();
+	if (!tasks.isEmpty())
+	{
+		const auto number = tasks.lastKey() + 1;
+		const auto title = tr("Pomodoro %1 - %2").arg(number).arg(tasks.last());
+
+		if (m_vp8_interface)
+			m_vp8_interface->setChapterTitle(title);
+	}
+
+	onBreakEnd();
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::onBreakEnd()
+{
+	m_chapterTitle.clear();
+	m_pomodoroNumber = 0;
+
+	if (m_vp8_interface)
+	{
+		m_vp8_interface->endChapter();
+		m_vp8_interface->setPomodoro(0);
+	}
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::updateTextTracks()
+{
+	if (m_clockTrack != 0)
+		m_vp8_interface->setText(m_clockTrack, QDateTime::currentDateTime().time().toString("hh:mm:ss"));
+
+	if (m_pomodoroTrack != 0)
+	{
+		QString text;
+		switch (m_pomodoro->status())
+		{
+			case Pomodoro::Status::Pomodoro:
+				text = tr("Pomodoro %1 - %2").arg(m_pomodoro->completedPomodoros() + 1).arg(m_pomodoro->getTaskTitle());
+				break;
+			case Pomodoro::Status::ShortBreak:
+				text = tr("Short break");
+				break;
+			case Pomodoro::Status::LongBreak:
+				text = tr("Long break");
+				break;
+			case Pomodoro::Status::Paused:
+				text = tr("Paused");
+				break;
+			default:
+			case Pomodoro::Status::Stopped:
+				break;
+		}
+
+		m_vp8_interface->setText(m_pomodoroTrack, text);
+	}
+}
+
+//-----------------------------------------------------------------
+QString DesktopCapture::videoFileName() const
+{
+	// never overwrite the videos of a previous capture of the same day.
+	const auto baseName = m_dirEditLabel->text() + QString("\\DesktopCapture_") + QDateTime::currentDateTime().toString("dd_MM_yyyy");
+
+	auto fileName = baseName + QString(".webm");
+	for (int i = 1; QFile::exists(fileName); ++i)
+		fileName = baseName + QString("_%1.webm").arg(i, 2, 10, QChar('0'));
+
+	return fileName;
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::createVideoInterface()
+{
+	if (m_vp8_interface)
+	{
+		// the footer and the sync to disk of the previous file don't block the capture.
+		waitVideoFileClose();
+
+		// the thread holds the only reference, the interface is always destroyed there.
+		m_closeThread.reset(QThread::create([previous = std::move(m_vp8_interface)]() mutable { previous = nullptr; }));
+		m_closeThread->start();
+	}
+
+	const auto desktopGeometry = captureGeometry();
+	const auto durability = static_cast<AsyncFileWriter::Durability>(std::clamp(m_config.captureVideoDurability, 0, 2));
+	const auto preallocation = static_cast<qint64>(std::max(0, m_config.captureVideoPreallocation)) * 1024 * 1024;
+
+	const auto fileName = videoFileName();
+
+	m_vp8_interface = std::make_shared<VPX_Interface>(fileName, desktopGeometry.height(), desktopGeometry.width(), m_fps->value(), m_scale, durability, preallocation);
+	m_vp8_interface->setCheckpointInterval(m_config.captureVideoCheckpoint);
+	m_vp8_interface->setConstantFrameRate(m_config.captureVideoConstantRate);
+	m_vp8_interface->setCaptureInterval(m_timer.interval());
+	m_vp8_interface->setPomodoro(m_pomodoroNumber);
+	m_vp8_interface->setClusterChecksums(m_config.captureVideoChecksums);
+	m_vp8_interface->setKeyFrames(m_config.captureVideoKeyFrameDistance, m_config.captureVideoSceneThreshold);
+
+	const auto baseName = fileName.left(fileName.lastIndexOf('.'));
+	if (m_config.captureVideoIndex)
+		m_vp8_interface->setFrameIndex(baseName + QString(".idx"));
+
+	if (m_config.captureThumbnails)
+		m_vp8_interface->setThumbnails(baseName + QString("_thumbnails.jpg"), m_config.captureThumbnailsInterval, m_config.captureThumbnailsWidth);
+
+	if (m_cameraEnabled->isChecked() && m_config.cameraSeparateTrack && !m_cameraResolutions.empty())
+	{
+		const auto resolution = m_cameraResolutions.at(m_cameraResolutionComboBox->currentIndex());
+		m_vp8_interface->setCameraTrack(resolution.width, resolution.height, m_config.cameraTrackFrameInterval);
+	}
+
+	if (m_config.captureTextTrack)
+	{
+		if (m_config.timeOverlay)
+			m_clockTrack = m_vp8_interface->addTextTrack(tr("Clock"));
+
+		if (m_pomodoroGroupBox->isChecked())
+			m_pomodoroTrack = m_vp8_interface->addTextTrack(tr("Pomodoro"));
+	}
+
+	// the pomodoro starts before the first frame, or continues from the previous file.
+	if (!m_chapterTitle.isEmpty())
+		m_vp8_interface->markChapter(m_chapterTitle);
+
+	m_rotationPending = false;
+
+	// wall-clock rotation happens at multiples of the interval since midnight.
+	const qint64 interval = static_cast<qint64>(std::max(1, m_config.captureVideoRotationMinutes)) * 60 * 1000;
+	const auto now = QDateTime::currentDateTime();
+	const auto midnight = QDateTime(now.date(), QTime(0, 0));
+	m_rotationTime = midnight.addMSecs((midnight.msecsTo(now) / interval + 1) * interval);
+}
+
+//-----------------------------------------------------------------
+bool DesktopCapture::videoRotationNeeded() const
+{
+	if (!m_vp8_interface) return true;
+
+	switch (m_config.captureVideoRotation)
+	{
+		case 1:
+			return QDateTime::currentDateTime() >= m_rotationTime;
+		case 2:
+			return m_vp8_interface->fileSize() >= static_cast<qint64>(std::max(1, m_config.captureVideoRotationSize)) * 1024 * 1024;
+		case 3:
+			return m_rotationPending;
+		default:
+			break;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------
+void DesktopCapture::waitVideoFileClose()
+{
+	if (m_closeThread)
+	{
+		m_closeThread->wait();
+		m_closeThread = nullptr;
+	}
+}
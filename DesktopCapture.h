@@ -32,6 +32,8 @@
 #include <QSystemTrayIcon>
 #include <QPainter>
 #include <QMutex>
+#include <QThread>
+#include <QDateTime>
 
 // C++
 #include <memory>
@@ -328,6 +330,31 @@ class DesktopCapture
 		 */
 		void onTimeOverlayStateChanged(bool value);
 
+		/** \brief Starts a chapter in the video for the pomodoro that begins.
+		 *
+		 */
+		void onPomodoroBegin();
+
+		/** \brief Starts a chapter in the video for the short break that begins.
+		 *
+		 */
+		void onShortBreakBegin();
+
+		/** \brief Starts a chapter in the video for the long break that begins.
+		 *
+		 */
+		void onLongBreakBegin();
+
+		/** \brief Ends the chapter of the pomodoro with the title of the completed task.
+		 *
+		 */
+		void onPomodoroEnd();
+
+		/** \brief Ends the chapter of the break.
+		 *
+		 */
+		void onBreakEnd();
+
 	private:
 	  /** \brief Returns the time in text.
 	   * \param[in] time
@@ -407,6 +434,44 @@ class DesktopCapture
 	   */
 	  void recomputeOverlaysPositions();
 
+		/** \brief Starts a chapter in the video, or when the video starts if not yet created.
+		 * \param[in] title chapter title.
+		 *
+		 */
+		void markChapter(const QString &title);
+
+		/** \brief Connects/disconnects the pomodoro signals that mark the video chapters.
+		 * \param[in] enabled true to connect and false to disconnect.
+		 *
+		 */
+		void connectChapterSignals(bool enabled);
+
+		/** \brief Updates the texts of the video subtitles tracks with the time and the pomodoro status.
+		 *
+		 */
+		void updateTextTracks();
+
+		/** \brief Returns the name of a new video file, different from the existing ones.
+		 *
+		 */
+		QString videoFileName() const;
+
+		/** \brief Creates the video file and its encoder. The previous video file, if any, is finished
+		 *  in a separate thread.
+		 *
+		 */
+		void createVideoInterface();
+
+		/** \brief Returns true if the video must continue in a new file.
+		 *
+		 */
+		bool videoRotationNeeded() const;
+
+		/** \brief Waits until the previous video file has been finished.
+		 *
+		 */
+		void waitVideoFileClose();
+
 		/** \brief Helper method that returns the list of monitors as string.
 		 *
 		 */
@@ -426,6 +491,13 @@ class DesktopCapture
 		std::shared_ptr<VPX_Interface>        m_vp8_interface;          /** VPX codec interface.                         */
 		float                                 m_scale;                  /** output scale ratio.                          */
 		bool                                  m_paused;                 /** true if pomodoro is paused, false otherwise. */
+		QString                               m_chapterTitle;           /** title of the current video chapter.          */
+		unsigned int                          m_clockTrack;             /** video clock subtitles track, 0 if none.      */
+		unsigned int                          m_pomodoroTrack;          /** video pomodoro subtitles track, 0 if none.   */
+		std::unique_ptr<QThread>              m_closeThread;            /** thread finishing the previous video file.    */
+		QDateTime                             m_rotationTime;           /** time of the next wall-clock file rotation.   */
+		bool                                  m_rotationPending;        /** true to rotate the file on the next frame.   */
+		unsigned int                          m_pomodoroNumber;         /** number of the current pomodoro, 0 if none.   */
 
 		QAction *m_menuPause;         /** tray menu pause.                    */
 		QAction *m_menuShowStats;     /** tray menu show pomodoro statistics. */
@@ -0,0 +1,71 @@
+/*
+    File: FrameIndex.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <FrameIndex.h>
+
+// C++
+#include <algorithm>
+#include <string.h>
+
+//------------------------------------------------------------------
+const FrameIndex::Record *FrameIndex::records(const uchar *data, const quint64 size, long long &count)
+{
+  count = 0;
+  if(!data || size < sizeof(Header)) return nullptr;
+
+  Header header;
+  ::memcpy(&header, data, sizeof(Header));
+  if(::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.recordSize != sizeof(Record))
+    return nullptr;
+
+  count = static_cast<long long>((size - sizeof(Header)) / sizeof(Record));
+
+  return reinterpret_cast<const Record *>(data + sizeof(Header));
+}
+
+//------------------------------------------------------------------
+long long FrameIndex::find(const Record *records, const long long count, const qint64 timestamp, const unsigned int track)
+{
+  if(!records || count <= 0) return -1;
+
+  const auto after = std::upper_bound(records, records + count, timestamp, [](const qint64 value, const Record &record) { return value < record.timestamp; });
+
+  // the frames of the other tracks are interleaved with the same capture times.
+  for(auto index = static_cast<long long>(after - records) - 1; index >= 0; --index)
+  {
+    if(records[index].track == track) return index;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------
+long long FrameIndex::keyFrame(const Record *records, const long long index)
+{
+  if(!records || index < 0) return -1;
+
+  const auto track = records[index].track;
+  for(auto i = index; i >= 0; --i)
+  {
+    if(records[i].track == track && (records[i].flags & KEYFRAME)) return i;
+  }
+
+  return -1;
+}
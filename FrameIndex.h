@@ -0,0 +1,95 @@
+/*
+    File: FrameIndex.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_INDEX_H_
+#define FRAME_INDEX_H_
+
+// Qt
+#include <QtGlobal>
+
+/** \brief Sidecar index of the frames of a video file. The file has a header followed by fixed size
+ *  records, one per frame in file order, in little endian. It can be mapped and searched by capture time
+ *  without parsing the video.
+ *
+ */
+namespace FrameIndex
+{
+  static const char    MAGIC[4] = { 'D', 'C', 'F', 'I' }; /** file identifier.  */
+  static const quint16 VERSION  = 1;                      /** format version.   */
+  static const quint8  KEYFRAME = 0x01;                   /** keyframe flag.    */
+
+  /** \struct Header
+   * \brief Index file header.
+   */
+  struct Header
+  {
+    char    magic[4];    /** file identifier, MAGIC.       */
+    quint16 version;     /** format version, VERSION.      */
+    quint16 recordSize;  /** size of a record in bytes.    */
+    quint32 fps;         /** frames per second of the video. */
+    quint32 reserved;    /** unused, zero.                 */
+  };
+
+  /** \struct Record
+   * \brief Index entry of a frame.
+   */
+  struct Record
+  {
+    qint64  timestamp;   /** capture time in milliseconds since the epoch, UTC.   */
+    quint64 offset;      /** position of the SimpleBlock element in the video file. */
+    quint32 time;        /** time of the frame in the video in milliseconds.        */
+    quint32 size;        /** size of the frame data in bytes.                      */
+    quint32 pomodoro;    /** number of the pomodoro in the session, 0 if none.      */
+    quint16 track;       /** track number of the frame.                            */
+    quint8  flags;       /** frame flags, KEYFRAME.                                */
+    quint8  reserved;    /** unused, zero.                                         */
+  };
+
+  static_assert(sizeof(Header) == 16, "Unexpected frame index header size.");
+  static_assert(sizeof(Record) == 32, "Unexpected frame index record size.");
+
+  /** \brief Returns the records of the index in the given data, or nullptr if it's not a valid index.
+   *  An incomplete last record (unfinished file) is ignored.
+   * \param[in] data index file data.
+   * \param[in] size size of the data in bytes.
+   * \param[out] count number of records.
+   *
+   */
+  const Record *records(const uchar *data, const quint64 size, long long &count);
+
+  /** \brief Returns the index of the last frame of the track captured at or before the given time, or -1
+   *  if none. The records are ordered by capture time so it's a binary search.
+   * \param[in] records index records.
+   * \param[in] count number of records.
+   * \param[in] timestamp capture time in milliseconds since the epoch.
+   * \param[in] track track number.
+   *
+   */
+  long long find(const Record *records, const long long count, const qint64 timestamp, const unsigned int track = 1);
+
+  /** \brief Returns the index of the keyframe the decoding of the given frame must start from, or -1
+   *  if none. The frames from the keyframe to the given one are contiguous in the video file.
+   * \param[in] records index records.
+   * \param[in] index index of the frame.
+   *
+   */
+  long long keyFrame(const Record *records, const long long index);
+}
+
+#endif // FRAME_INDEX_H_
@@ -0,0 +1,148 @@
+/*
+    File: I420Overlay.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <I420Overlay.h>
+
+// libvpx
+#include <vpx/vpx_image.h>
+
+// C++
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  // BT.601 studio range, the same coefficients libyuv uses in ARGBToI420().
+  inline int toY(const int r, const int g, const int b)
+  { return (66 * r + 129 * g + 25 * b + 0x1080) >> 8; }
+
+  inline int toU(const int r, const int g, const int b)
+  { return (112 * b - 74 * g - 38 * r + 0x8080) >> 8; }
+
+  inline int toV(const int r, const int g, const int b)
+  { return (112 * r - 94 * g - 18 * b + 0x8080) >> 8; }
+
+  /** \brief Blends a single sprite already scaled to the image, placed at the given position.
+   * \param[in] image I420 image.
+   * \param[in] sprite scaled sprite in non premultiplied ARGB32.
+   * \param[in] x horizontal position in the image, can be odd.
+   * \param[in] y vertical position in the image, can be odd.
+   *
+   */
+  void blendSprite(vpx_image *image, const QImage &sprite, const int x, const int y)
+  {
+    const int width = sprite.width();
+    const int height = sprite.height();
+
+    // chroma blocks covered by the sprite, the partially covered ones blend with less alpha.
+    const int cx0 = x / 2;
+    const int cy0 = y / 2;
+    const int cWidth = (x + width + 1) / 2 - cx0;
+    const int cHeight = (y + height + 1) / 2 - cy0;
+    std::vector<int> sumA(cWidth * cHeight, 0), sumU(cWidth * cHeight, 0), sumV(cWidth * cHeight, 0);
+
+    for(int j = 0; j < height; ++j)
+    {
+      const auto line = reinterpret_cast<const quint32 *>(sprite.constScanLine(j));
+      auto yRow = image->planes[0] + (y + j) * image->stride[0] + x;
+      const int cRow = ((y + j) / 2 - cy0) * cWidth;
+
+      for(int i = 0; i < width; ++i)
+      {
+        const auto pixel = line[i];
+        const int a = pixel >> 24;
+        if(a == 0) continue;
+
+        const int r = (pixel >> 16) & 0xFF;
+        const int g = (pixel >> 8) & 0xFF;
+        const int b = pixel & 0xFF;
+
+        const int value = yRow[i] * (255 - a) + toY(r, g, b) * a;
+        yRow[i] = (value + (value >> 8) + 0x80) >> 8;
+
+        const int c = cRow + (x + i) / 2 - cx0;
+        sumA[c] += a;
+        sumU[c] += toU(r, g, b) * a;
+        sumV[c] += toV(r, g, b) * a;
+      }
+    }
+
+    // each chroma sample is the mean of the blended samples of its pixels, four except in the last
+    // column and row of the odd sized images.
+    const int imageWidth = static_cast<int>(image->d_w);
+    const int imageHeight = static_cast<int>(image->d_h);
+    for(int j = 0; j < cHeight; ++j)
+    {
+      auto uRow = image->planes[1] + (cy0 + j) * image->stride[1] + cx0;
+      auto vRow = image->planes[2] + (cy0 + j) * image->stride[2] + cx0;
+      const int rows = std::min(2, imageHeight - 2 * (cy0 + j));
+
+      for(int i = 0; i < cWidth; ++i)
+      {
+        const int c = j * cWidth + i;
+        const int a = sumA[c];
+        if(a == 0) continue;
+
+        const int full = rows * std::min(2, imageWidth - 2 * (cx0 + i)) * 255;
+        uRow[i] = (uRow[i] * (full - a) + sumU[c] + full / 2) / full;
+        vRow[i] = (vRow[i] * (full - a) + sumV[c] + full / 2) / full;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void I420Overlay::blend(vpx_image *image, const QSize &desktopSize, const QList<Sprite> &sprites)
+{
+  if(!image || desktopSize.isEmpty()) return;
+
+  const int imageWidth = static_cast<int>(image->d_w);
+  const int imageHeight = static_cast<int>(image->d_h);
+  const double scaleX = static_cast<double>(imageWidth) / desktopSize.width();
+  const double scaleY = static_cast<double>(imageHeight) / desktopSize.height();
+
+  for(const auto &sprite: sprites)
+  {
+    if(sprite.image.isNull()) continue;
+
+    // bounds in the video image, the sprite is scaled to them and clipped.
+    const int x0 = static_cast<int>(std::lround(sprite.position.x() * scaleX));
+    const int y0 = static_cast<int>(std::lround(sprite.position.y() * scaleY));
+    const int x1 = static_cast<int>(std::lround((sprite.position.x() + sprite.image.width()) * scaleX));
+    const int y1 = static_cast<int>(std::lround((sprite.position.y() + sprite.image.height()) * scaleY));
+    if(x1 <= x0 || y1 <= y0) continue;
+
+    auto scaled = sprite.image;
+    if(scaled.width() != x1 - x0 || scaled.height() != y1 - y0)
+      scaled = scaled.scaled(x1 - x0, y1 - y0, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    const int left = std::max(0, -x0);
+    const int top = std::max(0, -y0);
+    const int right = std::min(x1, imageWidth) - x0;
+    const int bottom = std::min(y1, imageHeight) - y0;
+    if(right <= left || bottom <= top) continue;
+
+    if(left != 0 || top != 0 || right != scaled.width() || bottom != scaled.height())
+      scaled = scaled.copy(left, top, right - left, bottom - top);
+
+    blendSprite(image, scaled.convertToFormat(QImage::Format_ARGB32), x0 + left, y0 + top);
+  }
+}
@@ -0,0 +1,53 @@
+/*
+    File: I420Overlay.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef I420_OVERLAY_H_
+#define I420_OVERLAY_H_
+
+// Qt
+#include <QImage>
+#include <QPoint>
+#include <QSize>
+#include <QList>
+
+struct vpx_image;
+
+namespace I420Overlay
+{
+  /** \struct Sprite
+   * \brief Overlay painted over the desktop with the SourceOver composition.
+   */
+  struct Sprite
+  {
+    QImage image;    /** overlay image, premultiplied ARGB32 or opaque. */
+    QPoint position; /** position of the top left corner in the desktop. */
+  };
+
+  /** \brief Blends the sprites over the I420 image of the video. The sprites are scaled from the
+   *  desktop size to the image size and converted to YUV, the cost depends only on the area of the
+   *  sprites in the image. The chroma of each 2x2 block is blended with the mean alpha of its pixels.
+   * \param[in] image I420 image of the video.
+   * \param[in] desktopSize size of the desktop the sprite positions refer to.
+   * \param[in] sprites overlays to blend, in painting order.
+   *
+   */
+  void blend(vpx_image *image, const QSize &desktopSize, const QList<Sprite> &sprites);
+}
+
+#endif // I420_OVERLAY_H_
@@ -19,11 +19,62 @@
 
 // Project
 #include <DesktopCapture.h>
+#include <WebMTools.h>
+#include <WebMReader.h>
 
 // Qt
 #include <QApplication>
 #include <QSharedMemory>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+
+// C++
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace
+{
+	/** \brief Attaches the standard streams to the console of the parent process, if any. The
+	 *  application is linked as a GUI one and has no console of its own.
+	 *
+	 */
+	void attachConsole()
+	{
+#ifdef _WIN32
+		// redirected streams are inherited and valid, only the console ones must be opened.
+		if(AttachConsole(ATTACH_PARENT_PROCESS))
+		{
+			if(GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) == FILE_TYPE_UNKNOWN) freopen("CONOUT$", "w", stdout);
+			if(GetFileType(GetStdHandle(STD_ERROR_HANDLE)) == FILE_TYPE_UNKNOWN) freopen("CONOUT$", "w", stderr);
+		}
+#endif
+	}
+
+	/** \brief Writes the given line in the standard output.
+	 * \param[in] text text of the line.
+	 *
+	 */
+	void printLine(const QString &text)
+	{
+		QTextStream(stdout) << text << Qt::endl;
+	}
+
+	/** \brief Writes the given line in the standard error.
+	 * \param[in] text text of the line.
+	 *
+	 */
+	void printError(const QString &text)
+	{
+		QTextStream(stderr) << text << Qt::endl;
+	}
+}
 
 int main(int argc, char *argv[])
 {
@@ -33,6 +84,135 @@ int main(int argc, char *argv[])
 	// but only on linux because of X11 architecture.
 	app.setQuitOnLastWindowClosed(false);
 
+	// the command line modes report in the console they are run from.
+	const auto arguments = app.arguments();
+	if(arguments.size() > 1 && arguments.at(1).startsWith("--"))
+	{
+		attachConsole();
+	}
+
+	// join video files without re-encoding: DesktopCapture --concatenate output.webm input1.webm input2.webm...
+	if(arguments.size() > 1 && arguments.at(1) == "--concatenate")
+	{
+		if(arguments.size() < 4)
+		{
+			printError(QString("Usage: %1 --concatenate output.webm input1.webm [input2.webm...]").arg(arguments.at(0)));
+			return 1;
+		}
+
+		QString error;
+		if(!WebMTools::concatenate(arguments.mid(3), arguments.at(2), error))
+		{
+			printError(QString("Unable to join the files: %1").arg(error));
+			return 1;
+		}
+
+		printLine(QString("Joined %1 files in %2").arg(arguments.size() - 3).arg(arguments.at(2)));
+		return 0;
+	}
+
+	// repair the files of recordings that didn't finish: DesktopCapture --repair file1.webm [file2.webm...]
+	if(arguments.size() > 1 && arguments.at(1) == "--repair")
+	{
+		if(arguments.size() < 3)
+		{
+			printError(QString("Usage: %1 --repair file1.webm [file2.webm...]").arg(arguments.at(0)));
+			return 1;
+		}
+
+		auto returnValue = 0;
+		for(const auto &file: arguments.mid(2))
+		{
+			QString error;
+			if(!WebMTools::repair(file, error))
+			{
+				printError(QString("Unable to repair %1: %2").arg(file).arg(error));
+				returnValue = 1;
+				continue;
+			}
+
+			printLine(QString("%1: repaired or not damaged.").arg(file));
+		}
+
+		return returnValue;
+	}
+
+	// check the cluster checksums of recordings: DesktopCapture --verify file1.webm [file2.webm...]
+	if(arguments.size() > 1 && arguments.at(1) == "--verify")
+	{
+		if(arguments.size() < 3)
+		{
+			printError(QString("Usage: %1 --verify file1.webm [file2.webm...]").arg(arguments.at(0)));
+			return 1;
+		}
+
+		auto returnValue = 0;
+		for(const auto &file: arguments.mid(2))
+		{
+			WebMReader reader(file);
+			if(!reader.open())
+			{
+				printError(QString("Unable to read %1: %2").arg(file).arg(reader.error()));
+				returnValue = 1;
+				continue;
+			}
+
+			const auto &clusters = reader.clusters();
+			const auto checked = std::count_if(clusters.cbegin(), clusters.cend(), [](const WebMReader::Cluster &c) { return c.hasCrc; });
+			if(checked == 0)
+			{
+				printLine(QString("%1: has no cluster checksums.").arg(file));
+				continue;
+			}
+
+			const auto damaged = reader.verify();
+			for(const auto index: damaged)
+			{
+				const auto &cluster = clusters.at(index);
+				printLine(QString("%1: cluster %2 at offset %3 time %4 ms is damaged.").arg(file).arg(index).arg(cluster.element.offset).arg(cluster.timecode));
+			}
+
+			printLine(QString("%1: %2 clusters checked, %3 damaged%4").arg(file).arg(checked).arg(damaged.size()).arg(reader.isTruncated() ? " (truncated)." : "."));
+			if(!damaged.empty()) returnValue = 1;
+		}
+
+		return returnValue;
+	}
+
+	// measure the parsing throughput of recordings: DesktopCapture --benchmark file1.webm [file2.webm...]
+	if(arguments.size() > 1 && arguments.at(1) == "--benchmark")
+	{
+		if(arguments.size() < 3)
+		{
+			printError(QString("Usage: %1 --benchmark file1.webm [file2.webm...]").arg(arguments.at(0)));
+			return 1;
+		}
+
+		auto returnValue = 0;
+		for(const auto &file: arguments.mid(2))
+		{
+			// the first pass may read the file from disk, the second one finds it in the page cache.
+			for(const auto pass: {"first", "cached"})
+			{
+				WebMReader reader(file);
+				if(!reader.open())
+				{
+					printError(QString("Unable to read %1: %2").arg(file).arg(reader.error()));
+					returnValue = 1;
+					break;
+				}
+
+				const auto megabytes = static_cast<double>(QFileInfo(file).size()) / (1024. * 1024.);
+				const auto seconds = reader.throughput() == 0 ? 0 : megabytes / reader.throughput();
+				printLine(QString("%1 (%2): %3 MB, %4 frames, %5 clusters in %6 ms, %7 MB/s").arg(file).arg(pass)
+				          .arg(megabytes, 0, 'f', 1).arg(reader.frames().size()).arg(reader.clusters().size())
+				          .arg(static_cast<qint64>(seconds * 1000)).arg(reader.throughput(), 0, 'f', 1));
+			}
+		}
+
+		return returnValue;
+	}
+
 	// allow only one instance
   QSharedMemory guard;
   guard.setKey("DesktopCapture");
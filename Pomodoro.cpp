@@ -354,7 +354,10 @@ void Pomodoro::setLongBreakDuration(QTime duration)
 //-----------------------------------------------------------------
 void Pomodoro::setTaskTitle(QString taskTitle)
 {
+	if (m_task == taskTitle) return;
+
 	m_task = taskTitle;
+	emit taskTitleChanged();
 }
 
 //-----------------------------------------------------------------
@@ -243,6 +243,7 @@ class Pomodoro
 		void longBreakEnded();
 		void progress(unsigned int);
 		void sessionEnded();
+		void taskTitleChanged();
 
 	protected:
 		virtual void timerEvent(QTimerEvent *e) override;
@@ -0,0 +1,190 @@
+/*
+    File: ThumbnailAtlas.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <ThumbnailAtlas.h>
+
+// libyuv
+#include "libyuv/convert_argb.h"
+#include "libyuv/scale.h"
+
+// Qt
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+
+// C++
+#include <algorithm>
+#include <string.h>
+
+//------------------------------------------------------------------
+ThumbnailAtlas::ThumbnailAtlas(const QString &fileName, const int width, const int height)
+: m_fileName{fileName}
+, m_width   {std::max(2, width - (width % 2))}
+, m_height  {std::max(2, height - (height % 2))}
+, m_stop    {false}
+{
+}
+
+//------------------------------------------------------------------
+ThumbnailAtlas::~ThumbnailAtlas()
+{
+  close();
+}
+
+//------------------------------------------------------------------
+void ThumbnailAtlas::addFrame(const unsigned char *const planes[3], const int strides[3], const int width, const int height, const qint64 time, const qint64 timestamp)
+{
+  {
+    QMutexLocker lock(&m_mutex);
+    if(m_stop || m_queue.size() >= static_cast<size_t>(MAX_PENDING)) return;
+  }
+
+  const auto chromaWidth  = m_width / 2;
+  const auto chromaHeight = m_height / 2;
+
+  Thumbnail thumbnail;
+  thumbnail.time      = time;
+  thumbnail.timestamp = timestamp;
+  thumbnail.data.resize(m_width * m_height + 2 * chromaWidth * chromaHeight);
+
+  auto y = thumbnail.data.data();
+  auto u = y + m_width * m_height;
+  auto v = u + chromaWidth * chromaHeight;
+
+  // the thumbnail is a small fraction of the frame, the box filter reads each source pixel once.
+  libyuv::I420Scale(planes[0], strides[0], planes[1], strides[1], planes[2], strides[2], width, height,
+                    y, m_width, u, chromaWidth, v, chromaWidth, m_width, m_height, libyuv::kFilterBox);
+
+  QMutexLocker lock(&m_mutex);
+  m_queue.push_back(std::move(thumbnail));
+  m_ready.wakeOne();
+}
+
+//------------------------------------------------------------------
+void ThumbnailAtlas::close()
+{
+  {
+    QMutexLocker lock(&m_mutex);
+    m_stop = true;
+    m_ready.wakeOne();
+  }
+
+  if(isRunning())
+  {
+    wait();
+  }
+}
+
+//------------------------------------------------------------------
+void ThumbnailAtlas::run()
+{
+  while(true)
+  {
+    Thumbnail thumbnail;
+
+    {
+      QMutexLocker lock(&m_mutex);
+      while(m_queue.empty() && !m_stop)
+      {
+        m_ready.wait(&m_mutex);
+      }
+
+      // the pending thumbnails are packed before stopping.
+      if(m_queue.empty()) break;
+
+      thumbnail = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    pack(thumbnail);
+  }
+
+  save();
+}
+
+//------------------------------------------------------------------
+void ThumbnailAtlas::pack(const Thumbnail &thumbnail)
+{
+  const auto index = static_cast<int>(m_tiles.size());
+  const auto x = (index % COLUMNS) * m_width;
+  const auto y = (index / COLUMNS) * m_height;
+
+  if(y + m_height > MAX_HEIGHT) return;
+
+  // the atlas doubles its height when full, the new rows are black.
+  if(m_atlas.isNull() || y + m_height > m_atlas.height())
+  {
+    const auto height = std::min(MAX_HEIGHT, std::max(y + m_height, 2 * m_atlas.height()));
+
+    QImage atlas(COLUMNS * m_width, height, QImage::Format_RGB32);
+    atlas.fill(Qt::black);
+    if(!m_atlas.isNull())
+    {
+      ::memcpy(atlas.bits(), m_atlas.constBits(), m_atlas.sizeInBytes());
+    }
+    m_atlas = atlas;
+  }
+
+  const auto chromaWidth = m_width / 2;
+  const auto data = thumbnail.data.data();
+  const auto u = data + m_width * m_height;
+  const auto v = u + chromaWidth * (m_height / 2);
+
+  libyuv::I420ToARGB(data, m_width, u, chromaWidth, v, chromaWidth,
+                     m_atlas.scanLine(y) + x * 4, m_atlas.bytesPerLine(), m_width, m_height);
+
+  Tile tile;
+  tile.x         = x;
+  tile.y         = y;
+  tile.time      = thumbnail.time;
+  tile.timestamp = thumbnail.timestamp;
+  m_tiles.push_back(tile);
+}
+
+//------------------------------------------------------------------
+void ThumbnailAtlas::save()
+{
+  if(m_tiles.empty()) return;
+
+  const auto tiles = static_cast<int>(m_tiles.size());
+  const auto width = std::min(tiles, static_cast<int>(COLUMNS)) * m_width;
+  const auto height = ((tiles + COLUMNS - 1) / COLUMNS) * m_height;
+
+  if(!m_atlas.copy(0, 0, width, height).save(m_fileName, nullptr, 85))
+  {
+    qDebug() << "Unable to save thumbnails atlas" << m_fileName;
+  }
+
+  QFile table(m_fileName.left(m_fileName.lastIndexOf('.')) + QString(".csv"));
+  if(!table.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text))
+  {
+    qDebug() << "Unable to save thumbnails table" << table.fileName();
+    return;
+  }
+
+  QTextStream stream(&table);
+  stream << "tile,x,y,width,height,time,timestamp\n";
+  for(int i = 0; i < tiles; ++i)
+  {
+    const auto &tile = m_tiles.at(i);
+    stream << i << "," << tile.x << "," << tile.y << "," << m_width << "," << m_height << "," << tile.time << "," << tile.timestamp << "\n";
+  }
+}
@@ -0,0 +1,125 @@
+/*
+    File: ThumbnailAtlas.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THUMBNAIL_ATLAS_H_
+#define THUMBNAIL_ATLAS_H_
+
+// Qt
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <QImage>
+
+// C++
+#include <vector>
+#include <deque>
+
+/** \class ThumbnailAtlas
+ *  \brief Builds a contact sheet of a video in a separate thread. The frames are downscaled by the
+ *         caller to small I420 thumbnails, the color conversion and the packing in the atlas image
+ *         are done by the thread. When closed it writes the atlas image and a CSV table with the
+ *         position and time of every tile.
+ *
+ */
+class ThumbnailAtlas
+: public QThread
+{
+  public:
+    /** \brief ThumbnailAtlas class constructor. The thread must be started before adding frames.
+     * \param[in] fileName name of the atlas image file, the table has the same name with csv extension.
+     * \param[in] width width of the thumbnails in pixels.
+     * \param[in] height height of the thumbnails in pixels.
+     *
+     */
+    explicit ThumbnailAtlas(const QString &fileName, const int width, const int height);
+
+    /** \brief ThumbnailAtlas class virtual destructor. Packs the pending thumbnails and writes the files.
+     *
+     */
+    virtual ~ThumbnailAtlas();
+
+    /** \brief Downscales the I420 frame to a thumbnail and queues it. The frame is dropped if the thread
+     *  is behind, the capture is never blocked.
+     * \param[in] planes Y, U and V planes of the frame.
+     * \param[in] strides strides of the planes in bytes.
+     * \param[in] width width of the frame in pixels.
+     * \param[in] height height of the frame in pixels.
+     * \param[in] time time of the frame in the video in milliseconds.
+     * \param[in] timestamp capture time in milliseconds since the epoch.
+     *
+     */
+    void addFrame(const unsigned char *const planes[3], const int strides[3], const int width, const int height, const qint64 time, const qint64 timestamp);
+
+    /** \brief Packs the pending thumbnails, writes the atlas and the table and stops the thread.
+     *
+     */
+    void close();
+
+    virtual void run() final;
+
+    static constexpr int COLUMNS     = 10;    /** thumbnails per row of the atlas.                 */
+    static constexpr int MAX_PENDING = 8;     /** maximum number of thumbnails waiting to be packed. */
+    static constexpr int MAX_HEIGHT  = 65500; /** maximum height of the atlas, the limit of JPEG.   */
+
+  private:
+    /** \struct Thumbnail
+     * \brief Downscaled frame waiting to be packed.
+     */
+    struct Thumbnail
+    {
+      std::vector<unsigned char> data;          /** I420 planes of the thumbnail.                   */
+      qint64                     time      = 0; /** time of the frame in the video in milliseconds. */
+      qint64                     timestamp = 0; /** capture time in milliseconds since the epoch.   */
+    };
+
+    /** \struct Tile
+     * \brief Entry of the offsets table.
+     */
+    struct Tile
+    {
+      int    x         = 0; /** horizontal position in the atlas in pixels.     */
+      int    y         = 0; /** vertical position in the atlas in pixels.       */
+      qint64 time      = 0; /** time of the frame in the video in milliseconds. */
+      qint64 timestamp = 0; /** capture time in milliseconds since the epoch.   */
+    };
+
+    /** \brief Converts the thumbnail and copies it to the next tile of the atlas. Called from the thread.
+     * \param[in] thumbnail downscaled frame.
+     *
+     */
+    void pack(const Thumbnail &thumbnail);
+
+    /** \brief Writes the atlas image and the offsets table. Called from the thread.
+     *
+     */
+    void save();
+
+    const QString           m_fileName; /** atlas image file name.                   */
+    const int               m_width;    /** width of the thumbnails in pixels.       */
+    const int               m_height;   /** height of the thumbnails in pixels.      */
+    QImage                  m_atlas;    /** atlas image, grows with the thumbnails.  */
+    std::vector<Tile>       m_tiles;    /** offsets table.                           */
+    std::deque<Thumbnail>   m_queue;    /** thumbnails waiting to be packed.         */
+    bool                    m_stop;     /** true when the thread must finish.        */
+    QMutex                  m_mutex;    /** queue mutex.                             */
+    QWaitCondition          m_ready;    /** signaled when a thumbnail has been queued. */
+};
+
+#endif // THUMBNAIL_ATLAS_H_
@@ -39,6 +39,24 @@ const QString CAPTURED_MONITOR                   = "Captured Desktop Monitor";
 const QString MONITORS_LIST                      = "Monitor Resolutions";
 const QString OUTPUT_DIR                         = "Output Directory";
 const QString OUTPUT_SCALE                       = "Output Scale";
+const QString CAPTURE_VIDEO_CHECKPOINT           = "Capture Video Checkpoint Interval";
+const QString CAPTURE_VIDEO_DURABILITY           = "Capture Video Durability";
+const QString CAPTURE_VIDEO_PREALLOCATION        = "Capture Video Preallocation";
+const QString CAPTURE_VIDEO_ROTATION             = "Capture Video Rotation";
+const QString CAPTURE_VIDEO_ROTATION_MINUTES     = "Capture Video Rotation Minutes";
+const QString CAPTURE_VIDEO_ROTATION_SIZE        = "Capture Video Rotation Size";
+const QString CAPTURE_VIDEO_CONSTANT_RATE        = "Capture Video Constant Frame Rate";
+const QString CAPTURE_TEXT_TRACK                 = "Capture Text Track";
+const QString CAPTURE_VIDEO_INDEX                = "Capture Video Index";
+const QString CAPTURE_THUMBNAILS                 = "Capture Thumbnails";
+const QString CAPTURE_THUMBNAILS_INTERVAL        = "Capture Thumbnails Interval";
+const QString CAPTURE_THUMBNAILS_WIDTH           = "Capture Thumbnails Width";
+const QString CAPTURE_VIDEO_CHECKSUMS            = "Capture Video Checksums";
+const QString CAPTURE_VIDEO_KEYFRAME_DISTANCE    = "Capture Video Keyframe Distance";
+const QString CAPTURE_VIDEO_SCENE_THRESHOLD      = "Capture Video Scene Threshold";
+const QString CAPTURE_VIDEO_ROI                  = "Capture Video Regions Of Interest";
+const QString CAPTURE_VIDEO_BACKGROUND_QUANTIZER = "Capture Video Background Quantizer";
+const QString CAPTURE_VIDEO_SCALED_OVERLAYS      = "Capture Video Scaled Overlays";
 const QString APPLICATION_GEOMETRY               = "Application Geometry";
 const QString APPLICATION_STATE                  = "Application State";
 const QString CAMERA_ENABLED                     = "Camera Enabled";
@@ -51,6 +69,9 @@ const QString CAMERA_MASK                        = "Camera Mask";
 const QString CAMERA_TRACK_FACE                  = "Center face in camera picture";
 const QString CAMERA_TRACK_FACE_SMOOTH           = "Smooth face coordinates interpolation";
 const QString CAMERA_ASCII_ART                   = "Convert camera picture to ASCII art";
+const QString CAMERA_NORMALIZE_BRIGHTNESS        = "Normalize camera picture brightness";
+const QString CAMERA_SEPARATE_TRACK              = "Camera Separate Video Track";
+const QString CAMERA_TRACK_FRAME_INTERVAL        = "Camera Video Track Frame Interval";
 const QString POMODORO_TIME                      = "Pomodoro Time";
 const QString POMODORO_SHORT_BREAK_TIME          = "Short Break Time";
 const QString POMODORO_LONG_BREAK_TIME           = "Long Break Time";
@@ -126,6 +147,24 @@ void Configuration::load()
   captureVideoFPS = settings->value(CAPTURE_VIDEO_FPS, 15).toInt();
   captureOutputDir = settings->value(OUTPUT_DIR, QDir::homePath()).toString();
   captureScale = settings->value(OUTPUT_SCALE, 1).toInt();
+  captureVideoCheckpoint = settings->value(CAPTURE_VIDEO_CHECKPOINT, 5).toInt();
+  captureVideoDurability = settings->value(CAPTURE_VIDEO_DURABILITY, 0).toInt();
+  captureVideoPreallocation = settings->value(CAPTURE_VIDEO_PREALLOCATION, 64).toInt();
+  captureVideoRotation = settings->value(CAPTURE_VIDEO_ROTATION, 0).toInt();
+  captureVideoRotationMinutes = settings->value(CAPTURE_VIDEO_ROTATION_MINUTES, 60).toInt();
+  captureVideoRotationSize = settings->value(CAPTURE_VIDEO_ROTATION_SIZE, 2048).toInt();
+  captureVideoConstantRate = settings->value(CAPTURE_VIDEO_CONSTANT_RATE, false).toBool();
+  captureTextTrack = settings->value(CAPTURE_TEXT_TRACK, false).toBool();
+  captureVideoIndex = settings->value(CAPTURE_VIDEO_INDEX, false).toBool();
+  captureThumbnails = settings->value(CAPTURE_THUMBNAILS, false).toBool();
+  captureThumbnailsInterval = settings->value(CAPTURE_THUMBNAILS_INTERVAL, 300).toInt();
+  captureThumbnailsWidth = settings->value(CAPTURE_THUMBNAILS_WIDTH, 160).toInt();
+  captureVideoChecksums = settings->value(CAPTURE_VIDEO_CHECKSUMS, false).toBool();
+  captureVideoKeyFrameDistance = settings->value(CAPTURE_VIDEO_KEYFRAME_DISTANCE, 128).toInt();
+  captureVideoSceneThreshold = settings->value(CAPTURE_VIDEO_SCENE_THRESHOLD, 0).toInt();
+  captureVideoRegionsOfInterest = settings->value(CAPTURE_VIDEO_ROI, false).toBool();
+  captureVideoBackgroundQuantizer = settings->value(CAPTURE_VIDEO_BACKGROUND_QUANTIZER, 16).toInt();
+  captureVideoScaledOverlays = settings->value(CAPTURE_VIDEO_SCALED_OVERLAYS, false).toBool();
   captureEnabled = settings->value(CAPTURE_ENABLED, true).toBool();
   captureAnimateIcon = settings->value(CAPTURE_ANIMATED_TRAY_ENABLED, true).toBool();
 
@@ -154,6 +193,9 @@ void Configuration::load()
   cameraCenterFace = settings->value(CAMERA_TRACK_FACE, false).toBool();
   cameraFaceSmooth = settings->value(CAMERA_TRACK_FACE_SMOOTH, true).toBool();
   cameraASCIIart = settings->value(CAMERA_ASCII_ART, false).toBool();
+  cameraNormalizeBrightness = settings->value(CAMERA_NORMALIZE_BRIGHTNESS, false).toBool();
+  cameraSeparateTrack = settings->value(CAMERA_SEPARATE_TRACK, false).toBool();
+  cameraTrackFrameInterval = settings->value(CAMERA_TRACK_FRAME_INTERVAL, 1).toInt();
   cameraResolution = settings->value(CAMERA_ACTIVE_RESOLUTION, 0).toInt();
 
   if (settings->contains(CAMERA_RESOLUTIONS))
@@ -185,6 +227,24 @@ void Configuration::save()
   settings->setValue(CAPTURE_VIDEO_FPS, captureVideoFPS);
 	settings->setValue(OUTPUT_DIR, captureOutputDir);
 	settings->setValue(OUTPUT_SCALE, captureScale);
+	settings->setValue(CAPTURE_VIDEO_CHECKPOINT, captureVideoCheckpoint);
+	settings->setValue(CAPTURE_VIDEO_DURABILITY, captureVideoDurability);
+	settings->setValue(CAPTURE_VIDEO_PREALLOCATION, captureVideoPreallocation);
+	settings->setValue(CAPTURE_VIDEO_ROTATION, captureVideoRotation);
+	settings->setValue(CAPTURE_VIDEO_ROTATION_MINUTES, captureVideoRotationMinutes);
+	settings->setValue(CAPTURE_VIDEO_ROTATION_SIZE, captureVideoRotationSize);
+	settings->setValue(CAPTURE_VIDEO_CONSTANT_RATE, captureVideoConstantRate);
+	settings->setValue(CAPTURE_TEXT_TRACK, captureTextTrack);
+	settings->setValue(CAPTURE_VIDEO_INDEX, captureVideoIndex);
+	settings->setValue(CAPTURE_THUMBNAILS, captureThumbnails);
+	settings->setValue(CAPTURE_THUMBNAILS_INTERVAL, captureThumbnailsInterval);
+	settings->setValue(CAPTURE_THUMBNAILS_WIDTH, captureThumbnailsWidth);
+	settings->setValue(CAPTURE_VIDEO_CHECKSUMS, captureVideoChecksums);
+	settings->setValue(CAPTURE_VIDEO_KEYFRAME_DISTANCE, captureVideoKeyFrameDistance);
+	settings->setValue(CAPTURE_VIDEO_SCENE_THRESHOLD, captureVideoSceneThreshold);
+	settings->setValue(CAPTURE_VIDEO_ROI, captureVideoRegionsOfInterest);
+	settings->setValue(CAPTURE_VIDEO_BACKGROUND_QUANTIZER, captureVideoBackgroundQuantizer);
+	settings->setValue(CAPTURE_VIDEO_SCALED_OVERLAYS, captureVideoScaledOverlays);
 	settings->setValue(CAPTURE_ANIMATED_TRAY_ENABLED, captureAnimateIcon);
 
 	settings->setValue(CAMERA_ENABLED, cameraEnabled);
@@ -197,6 +257,9 @@ void Configuration::save()
   settings->setValue(CAMERA_TRACK_FACE, cameraCenterFace);
   settings->setValue(CAMERA_TRACK_FACE_SMOOTH, cameraFaceSmooth);
   settings->setValue(CAMERA_ASCII_ART, cameraASCIIart);
+  settings->setValue(CAMERA_NORMALIZE_BRIGHTNESS, cameraNormalizeBrightness);
+  settings->setValue(CAMERA_SEPARATE_TRACK, cameraSeparateTrack);
+  settings->setValue(CAMERA_TRACK_FRAME_INTERVAL, cameraTrackFrameInterval);
 	settings->setValue(CAMERA_ASCII_ART_RAMP, cameraASCIIArtRamp);
 	settings->setValue(CAMERA_ASCII_ART_RAMP_CHAR_SIZE, cameraASCIIArtCharacterSize);
 
@@ -241,12 +304,21 @@ std::unique_ptr<QSettings> applicationSettings()
 //-----------------------------------------------------------------
 QRect computeTimeOverlayRect(int pixelSize, const QPoint &p)
 {
+  // called for every frame, the font metrics are only built again when the size changes.
+  thread_local int metricsSize = -1;
+  thread_local std::unique_ptr<QFontMetrics> metrics;
+
+  if(!metrics || metricsSize != pixelSize)
+  {
+    QFont font;
+    font.setBold(true);
+    font.setPixelSize(pixelSize);
+    metrics = std::make_unique<QFontMetrics>(font);
+    metricsSize = pixelSize;
+  }
+
 	const auto timeText = QDateTime::currentDateTime().time().toString("hh:mm:ss");
-	QFont font;
-	font.setBold(true);
-	font.setPixelSize(pixelSize);
-	QFontMetrics fm(font);
-	auto timeRect = fm.boundingRect(timeText);
+	auto timeRect = metrics->boundingRect(timeText);
   timeRect.setWidth(timeRect.width()*1.3);
   timeRect.setHeight(timeRect.height()*1.1);
   const auto bottomRight = QPoint{p.x()+timeRect.width(), p.y()+timeRect.height()};
@@ -41,6 +41,24 @@ struct Configuration
   int captureMonitor = -1;                           /** -1 to capture all displays, otherwise index of the monitor to capture. */
   QString captureOutputDir;                          /** directory to store captures. */
   int captureScale = 0;                              /** index of the scale combo box. */
+  int captureVideoCheckpoint = 5;                    /** minutes between checkpoints of the video file, 0 to disable. */
+  int captureVideoDurability = 0;                    /** video file sync to disk policy: 0 none, 1 periodic, 2 on every cluster. */
+  int captureVideoPreallocation = 64;                /** megabytes of disk to preallocate for the video file, 0 to disable. */
+  int captureVideoRotation = 0;                      /** video file rotation: 0 none, 1 wall-clock interval, 2 file size, 3 pomodoro start. */
+  int captureVideoRotationMinutes = 60;              /** minutes between wall-clock rotations of the video file. */
+  int captureVideoRotationSize = 2048;               /** megabytes of the video file before rotation. */
+  bool captureVideoConstantRate = false;             /** true to resample the video to a constant frame rate, false to keep the capture times. */
+  bool captureTextTrack = false;                     /** true to write the time and pomodoro texts as subtitles instead of painting them. */
+  bool captureVideoIndex = false;                    /** true to write the sidecar index of the frames next to the video file. */
+  bool captureThumbnails = false;                    /** true to write a contact sheet of the video next to the video file. */
+  int captureThumbnailsInterval = 300;               /** frames of the video between thumbnails of the contact sheet. */
+  int captureThumbnailsWidth = 160;                  /** width in pixels of the thumbnails of the contact sheet. */
+  bool captureVideoChecksums = false;                /** true to write a CRC-32 in every cluster of the video. */
+  int captureVideoKeyFrameDistance = 128;            /** maximum number of frames between keyframes of the video. */
+  int captureVideoSceneThreshold = 0;                /** percentage of the desktop that must change to force a keyframe, 0 to let the encoder decide. */
+  bool captureVideoRegionsOfInterest = false;        /** true to encode the active window and overlays with more quality than the rest of the desktop. */
+  int captureVideoBackgroundQuantizer = 16;          /** quantizer delta of the desktop out of the regions of interest [0,63]. */
+  bool captureVideoScaledOverlays = false;           /** true to blend the overlays in the video after scaling the desktop instead of painting them. */
   QStringList monitors;                              /** detected monitors list. */
   QByteArray appGeometry;                            /** application geometry. */
   QByteArray appState;                               /** application state. */
@@ -54,6 +72,9 @@ struct Configuration
   bool cameraCenterFace = false;                     /** true to track and center the face int he camera image, false otherwise. */
   bool cameraFaceSmooth = true;                      /** smooth face coordinates processing. */
   bool cameraASCIIart = false;                       /** true to convert tha camera image to ASCII art, false otherwise. */
+  bool cameraNormalizeBrightness = false;            /** true to normalize the camera image brightness, false to normalize only the face detection image. */
+  bool cameraSeparateTrack = false;                  /** true to encode the camera in its own video track instead of the desktop image. */
+  int cameraTrackFrameInterval = 1;                  /** number of desktop frames per camera frame in the camera track. */
   bool pomodoroEnabled = true;                       /** true to use pomodoros and false otherwise. */
   QTime pomodoroTime = QTime(0, 25, 0);              /** time of pomodoro. */
   QTime pomodoroShortBreak = QTime(0, 5, 0);         /** time of pomodoro short break. */
@@ -19,6 +19,7 @@
 
 // Project
 #include <VPXInterface.h>
+#include <FrameIndex.h>
 
 // libyuv
 #include "libyuv/convert.h"
@@ -28,11 +29,17 @@
 #include <QImage>
 #include <QDebug>
 #include <QFile>
+#include <QDateTime>
+
+// C++
+#include <algorithm>
+#include <cstdlib>
 
 const int VPX_Interface::VP8_quality_values[3]{ VPX_DL_REALTIME, VPX_DL_GOOD_QUALITY, VPX_DL_BEST_QUALITY };
 
 //------------------------------------------------------------------
-VPX_Interface::VPX_Interface(const QString fileName, const int height, const int width, const int fps, const float scaleRatio)
+VPX_Interface::VPX_Interface(const QString fileName, const int height, const int width, const int fps, const float scaleRatio,
+                             const AsyncFileWriter::Durability durability, const qint64 preallocation)
 : m_vp8_filename{fileName}
 , m_width       {width - (width % 16)}
 , m_height      {height - (height % 16)}
@@ -41,19 +48,42 @@ VPX_Interface::VPX_Interface(const QString fileName, const int height, const int
 , m_hash        {0}
 , m_frameNumber {0}
 , m_fps         {fps}
+, m_constantRate{false}
+, m_startTime   {0}
+, m_captureInterval{0}
+, m_pts         {0}
+, m_duration    {1000/fps}
+, m_slot        {0}
+, m_checkpointInterval{0}
+, m_cameraTrack {0}
+, m_cameraInterval{1}
+, m_cameraKeyFrame{false}
+, m_chapterPending{false}
+, m_wallOffset  {0}
+, m_captureTime {0}
+, m_pomodoro    {0}
+, m_thumbnailInterval{1}
+, m_sceneThreshold{0}
+, m_keyFrameDistance{0}
+, m_sceneChanged{false}
+, m_roiDeltaQ   {0}
 {
   if(m_scale < 0.5) m_scale = 0.5;
   if(m_scale > 2.0) m_scale = 2.0;
 
 	memset(&m_ebml, 0, sizeof(EbmlGlobal));
 	m_ebml.last_pts_ms = -1;
+	m_clock.start();
 
-	// open output file
-	if(!(m_ebml.stream = fopen(m_vp8_filename.toStdString().c_str(), "wb")))
+	// open output file, the data is written to disk in a separate thread.
+	m_writer = std::make_unique<AsyncFileWriter>(m_vp8_filename, durability, preallocation);
+	if(!m_writer->isOpen())
 	{
 		qDebug() << "failed to open file" << m_vp8_filename;
 		return;
 	}
+	m_writer->start();
+	m_ebml.writer = m_writer.get();
 
 	// populate encoder configuration, we won't use VP9 because the 1-pass is
 	// not yet up to the task
@@ -80,8 +110,9 @@ VPX_Interface::VPX_Interface(const QString fileName, const int height, const int
 	m_vp8_config.rc_resize_allowed = 0;
 	m_vp8_config.rc_end_usage = VPX_VBR;
   m_vp8_config.g_bit_depth = VPX_BITS_12;
+	// the frames are stamped with their capture time in milliseconds, the resolution of the webm timecodes.
 	m_vp8_config.g_timebase.num = 1;
-	m_vp8_config.g_timebase.den = m_fps;
+	m_vp8_config.g_timebase.den = 1000;
 	m_vp8_config.g_threads = 4;
 	m_vp8_config.g_pass = VPX_RC_ONE_PASS;
 	m_vp8_config.g_profile = 0;            // Default profile.
@@ -89,7 +120,7 @@ VPX_Interface::VPX_Interface(const QString fileName, const int height, const int
   m_vp8_config.rc_max_quantizer = 63;    // 63 is maximum.
   m_vp8_config.kf_mode = VPX_KF_AUTO;    // Auto key frames.
 
-  m_ebml.framerate = m_vp8_config.g_timebase;
+  m_ebml.framerate = vpx_rational{m_fps, 1};
 
 	// Initialize codec
 	if (vpx_codec_enc_init(&m_vp8_context, vpx_codec_vp8_cx(), &m_vp8_config, 0))
@@ -115,8 +146,8 @@ VPX_Interface::VPX_Interface(const QString fileName, const int height, const int
     }
   }
 
-	struct vpx_rational framerate = {m_fps, 1};
-	write_webm_file_header(&m_ebml, &m_vp8_config, &framerate);
+	// the desktop is the first track, the header is written with the first frame.
+	webm_add_video_track(&m_ebml, m_vp8_config.g_w, m_vp8_config.g_h);
 }
 
 //------------------------------------------------------------------
@@ -129,18 +160,64 @@ VPX_Interface::~VPX_Interface()
 	if (vpx_codec_destroy(&m_vp8_context))
 		qDebug() << "Failed to destroy codec";
 
+	if (m_cameraTrack != 0)
+	{
+		vpx_img_free(&m_camera_rawImage);
+		if (vpx_codec_destroy(&m_camera_context))
+			qDebug() << "Failed to destroy camera codec";
+	}
+
 	if (m_frameNumber != 0)
 		write_webm_file_footer(&m_ebml, m_hash);
-	else
+
+	// waits for the pending data to be written.
+	m_writer->close();
+
+	if (m_indexWriter)
+		m_indexWriter->close();
+
+	// the atlas is written in its thread, it's empty if no frames were encoded.
+	m_thumbnails = nullptr;
+
+	if (m_frameNumber == 0)
+	{
 		QFile::remove(m_vp8_filename);
+		if (!m_indexFilename.isEmpty())
+			QFile::remove(m_indexFilename);
+	}
 
-	fclose(m_ebml.stream);
+	webm_release(&m_ebml);
 }
 
 //------------------------------------------------------------------
-void VPX_Interface::encodeFrame(QImage* frame)
+void VPX_Interface::encodeFrame(QImage* frame, const QImage *camera, const qint64 timestamp)
 {
+	const auto captureTime = timestamp < 0 ? m_clock.elapsed() : timestamp;
+
+	if (m_frameNumber == 0)
+	{
+		struct vpx_rational framerate = {m_fps, 1};
+		write_webm_file_header(&m_ebml, &m_vp8_config, &framerate);
+
+		// the capture times are monotonic, the index stores wall-clock times.
+		m_wallOffset = QDateTime::currentMSecsSinceEpoch() - captureTime;
+	}
+
+	const auto missing = computeFrameTime(captureTime);
+	if (missing < 0)
+		return;
+
+	// the raw image still has the previous frame, repeat it to fill the gap in constant frame rate.
+	for (long int i = missing; i > 0; --i)
+	{
+		const int64_t pts = static_cast<int64_t>(m_slot - i) * 1000 / m_fps;
+		const int64_t next = static_cast<int64_t>(m_slot - i + 1) * 1000 / m_fps;
+		if (encode(&m_vp8_context, &m_vp8_config, scalingEnabled() ? &m_vp8_rawImageScaled : &m_vp8_rawImage, pts, next - pts, 0, 1))
+			m_cameraKeyFrame = true;
+	}
+
 	++m_frameNumber;
+	m_captureTime = captureTime + m_wallOffset;
 
 	vpx_image_t *image;
 
@@ -167,6 +244,15 @@ void VPX_Interface::encodeFrame(QImage* frame)
 	else
 	  image = &m_vp8_rawImage;
 
+	if (!m_overlays.isEmpty())
+	{
+		I420Overlay::blend(image, QSize{m_width, m_height}, m_overlays);
+		m_overlays.clear();
+	}
+
+	if (m_thumbnails && ((m_frameNumber - 1) % m_thumbnailInterval) == 0)
+		m_thumbnails->addFrame(image->planes, image->stride, image->d_w, image->d_h, m_pts, m_captureTime);
+
 // DUMP RAW FRAME ///////////////////////////////////////////////////////////////
 //	QString frameName = QString("D:\\Descargas\\rawFrame") + QString::number(m_frameNumber) + QString(".raw");
 //	FILE *rawFrame = fopen(frameName.toStdString().c_str(), "wb");
@@ -177,20 +263,137 @@ void VPX_Interface::encodeFrame(QImage* frame)
 //		fclose(rawFrame);
 //	}
 
+	// chapters start with a keyframe so they can be reached with a single seek.
+	vpx_enc_frame_flags_t flags = 0;
+	if (m_chapterPending)
+	{
+		webm_add_chapter(&m_ebml, chapterTitle(m_chapterTitle).constData(), m_pts);
+		m_chapterPending = false;
+		flags = VPX_EFLAG_FORCE_KF;
+	}
+
+	if (m_sceneThreshold > 0)
+		flags |= keyFrameFlags(image);
+
+	// the camera keyframes follow the desktop ones so both tracks can be played from a cue point.
+	if (encode(&m_vp8_context, &m_vp8_config, image, m_pts, m_duration, flags, 1))
+		m_cameraKeyFrame = true;
+
+	if (m_cameraTrack != 0 && camera && !camera->isNull() && ((m_frameNumber - 1) % m_cameraInterval) == 0)
+	{
+		const auto width = static_cast<int>(m_camera_config.g_w);
+		const auto height = static_cast<int>(m_camera_config.g_h);
+
+		auto cameraImage = camera->convertToFormat(QImage::Format_RGB32);
+		if (cameraImage.width() != width || cameraImage.height() != height)
+			cameraImage = cameraImage.scaled(width, height, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+
+		libyuv::ARGBToI420(cameraImage.constBits(), cameraImage.bytesPerLine(),
+		                   m_camera_rawImage.planes[0], m_camera_rawImage.stride[0],
+		                   m_camera_rawImage.planes[1], m_camera_rawImage.stride[1],
+		                   m_camera_rawImage.planes[2], m_camera_rawImage.stride[2],
+		                   width, height);
+
+		const vpx_enc_frame_flags_t flags = m_cameraKeyFrame ? VPX_EFLAG_FORCE_KF : 0;
+		encode(&m_camera_context, &m_camera_config, &m_camera_rawImage, m_pts, m_duration * m_cameraInterval, flags, m_cameraTrack);
+		m_cameraKeyFrame = false;
+	}
+
+	// the muxer only writes the texts that have changed.
+	for (auto it = m_texts.constBegin(); it != m_texts.constEnd(); ++it)
+		write_webm_text(&m_ebml, it.key(), m_pts, it.value().constData());
+
+	if (m_checkpointInterval > 0 && m_checkpointTimer.hasExpired(m_checkpointInterval))
+	{
+		write_webm_checkpoint(&m_ebml, m_hash);
+		if (m_indexWriter)
+			m_indexWriter->sync();
+		m_checkpointTimer.restart();
+	}
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setCheckpointInterval(const int minutes)
+{
+	m_checkpointInterval = std::max(0, minutes) * 60 * 1000;
+	m_checkpointTimer.start();
+}
+
+//------------------------------------------------------------------
+bool VPX_Interface::setCameraTrack(const int width, const int height, const int frameInterval)
+{
+	if (m_frameNumber != 0 || m_cameraTrack != 0 || !m_writer || !m_writer->isOpen())
+	{
+		qDebug() << "Camera track must be added once before encoding";
+		return false;
+	}
+
+	auto res = vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &m_camera_config, 0);
+	if (VPX_CODEC_OK != res)
+	{
+		qDebug() << QString("Failed to get camera config: %1").arg(vpx_codec_err_to_string(res));
+		return false;
+	}
+
+	m_camera_config.g_w = width - (width % 16);
+	m_camera_config.g_h = height - (height % 16);
+	m_camera_config.rc_target_bitrate = 12 * m_camera_config.g_w * m_camera_config.g_h / 1024;
+	m_camera_config.rc_dropframe_thresh = 0;
+	m_camera_config.rc_resize_allowed = 0;
+	m_camera_config.rc_end_usage = VPX_VBR;
+	m_camera_config.g_timebase = m_vp8_config.g_timebase;
+	m_camera_config.g_threads = 2;
+	m_camera_config.g_pass = VPX_RC_ONE_PASS;
+	m_camera_config.g_profile = 0;
+	m_camera_config.rc_min_quantizer = 0;
+	m_camera_config.rc_max_quantizer = 63;
+	m_camera_config.kf_mode = VPX_KF_AUTO;
+
+	if (vpx_codec_enc_init(&m_camera_context, vpx_codec_vp8_cx(), &m_camera_config, 0))
+	{
+		qDebug() << "Failed to initialize camera encoder";
+		return false;
+	}
+
+	if (!vpx_img_alloc(&m_camera_rawImage, VPX_IMG_FMT_I420, m_camera_config.g_w, m_camera_config.g_h, 1))
+	{
+		qDebug() << "cannot allocate memory for camera image";
+		vpx_codec_destroy(&m_camera_context);
+		return false;
+	}
+
+	m_cameraTrack = webm_add_video_track(&m_ebml, m_camera_config.g_w, m_camera_config.g_h);
+	if (m_cameraTrack == 0)
+	{
+		vpx_img_free(&m_camera_rawImage);
+		vpx_codec_destroy(&m_camera_context);
+		return false;
+	}
+
+	m_cameraInterval = std::max(1, frameInterval);
+	m_cameraKeyFrame = true;
+
+	return true;
+}
+
+//------------------------------------------------------------------
+bool VPX_Interface::encode(vpx_codec_ctx_t *context, const vpx_codec_enc_cfg_t *config, vpx_image_t *image, vpx_codec_pts_t pts, unsigned long duration, vpx_enc_frame_flags_t flags, unsigned int track)
+{
 	vpx_codec_iter_t iter = nullptr;
 	const vpx_codec_cx_pkt_t *pkt;
+	bool keyFrame = false;
 
-	int result = vpx_codec_encode(&m_vp8_context, image, m_frameNumber, 1000/m_fps, 0, m_quality);
+	int result = vpx_codec_encode(context, image, pts, duration, flags, m_quality);
 	if (VPX_CODEC_OK != result)
 	{
-		qDebug() << "Failed to encode frame" << m_frameNumber;
+		qDebug() << "Failed to encode frame" << m_frameNumber << "of track" << track;
 		switch(result)
 		{
 			case VPX_CODEC_INCAPABLE:
 			  qDebug() << "codec incapable";
 			  break;
 			case VPX_CODEC_INVALID_PARAM:
-			  qDebug() << "invalid param" << QString(vpx_codec_error_detail(&m_vp8_context));
+			  qDebug() << "invalid param" << QString(vpx_codec_error_detail(context));
 			  break;
 			default:
 			  qDebug() << "unknown error";
@@ -198,14 +401,343 @@ void VPX_Interface::encodeFrame(QImage* frame)
 		}
 	}
 
-	while ((pkt = vpx_codec_get_cx_data(&m_vp8_context, &iter)))
+	while ((pkt = vpx_codec_get_cx_data(context, &iter)))
 	{
 		if (pkt->kind == VPX_CODEC_CX_FRAME_PKT)
 		{
 				m_hash = murmur(pkt->data.frame.buf, (int)pkt->data.frame.sz, m_hash);
-				write_webm_block(&m_ebml, &m_vp8_config, pkt);
+				write_webm_block(&m_ebml, config, pkt, track);
+				keyFrame |= (pkt->data.frame.flags & VPX_FRAME_IS_KEY) != 0;
+
+				if (m_indexWriter)
+				{
+					FrameIndex::Record record;
+					memset(&record, 0, sizeof(FrameIndex::Record));
+					record.timestamp = m_captureTime;
+					record.offset    = static_cast<quint64>(m_ebml.block_pos);
+					record.time      = static_cast<quint32>(m_ebml.track_list[track - 1].last_pts_ms);
+					record.size      = static_cast<quint32>(pkt->data.frame.sz);
+					record.pomodoro  = m_pomodoro;
+					record.track     = static_cast<quint16>(track);
+					record.flags     = (pkt->data.frame.flags & VPX_FRAME_IS_KEY) ? FrameIndex::KEYFRAME : 0;
+					m_indexWriter->write(&record, sizeof(FrameIndex::Record));
+				}
 		}
 	}
+
+	if (track == 1)
+	{
+		m_keyFrameDistance = keyFrame ? 0 : m_keyFrameDistance + 1;
+		m_sceneChanged &= !keyFrame;
+	}
+
+	return keyFrame;
+}
+
+//------------------------------------------------------------------
+double VPX_Interface::sceneChange(const vpx_image_t *image)
+{
+	const auto columns = static_cast<int>(image->d_w) / SCENE_STEP;
+	const auto rows = static_cast<int>(image->d_h) / SCENE_STEP;
+	const auto samples = static_cast<size_t>(columns) * rows;
+	if (samples == 0)
+		return 0;
+
+	// the first frame changes everything.
+	if (m_sceneSamples.size() != samples)
+	{
+		m_sceneSamples.assign(samples, 0);
+		for (int y = 0; y < rows; ++y)
+		{
+			const auto line = image->planes[0] + static_cast<size_t>(y) * SCENE_STEP * image->stride[0];
+			for (int x = 0; x < columns; ++x)
+				m_sceneSamples[static_cast<size_t>(y) * columns + x] = line[x * SCENE_STEP];
+		}
+		return 1;
+	}
+
+	// a sparse grid of the luma plane is enough to tell a window switch from a blinking cursor.
+	size_t changed = 0;
+	auto previous = m_sceneSamples.data();
+	for (int y = 0; y < rows; ++y)
+	{
+		const auto line = image->planes[0] + static_cast<size_t>(y) * SCENE_STEP * image->stride[0];
+		for (int x = 0; x < columns; ++x, ++previous)
+		{
+			const auto value = line[x * SCENE_STEP];
+			changed += std::abs(static_cast<int>(value) - static_cast<int>(*previous)) > SCENE_DIFFERENCE;
+			*previous = value;
+		}
+	}
+
+	return static_cast<double>(changed) / samples;
+}
+
+//------------------------------------------------------------------
+vpx_enc_frame_flags_t VPX_Interface::keyFrameFlags(const vpx_image_t *image)
+{
+	const auto change = sceneChange(image);
+
+	// app and workspace switches are the natural seek points, but not more than one per second of video.
+	m_sceneChanged |= (change >= m_sceneThreshold);
+	if (m_sceneChanged && m_keyFrameDistance >= static_cast<unsigned int>(m_fps))
+		return VPX_EFLAG_FORCE_KF;
+
+	// a keyframe of a static desktop doesn't add a seek point, wait until something changes.
+	if (m_keyFrameDistance >= m_vp8_config.kf_max_dist && change > STATIC_CHANGE)
+		return VPX_EFLAG_FORCE_KF;
+
+	return 0;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::markChapter(const QString &title)
+{
+	m_chapterPending = true;
+	m_chapterTitle = title;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setChapterTitle(const QString &title)
+{
+	if (m_chapterPending)
+		m_chapterTitle = title;
+	else
+		webm_set_chapter_title(&m_ebml, chapterTitle(title).constData());
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::endChapter()
+{
+	if (m_chapterPending)
+		m_chapterPending = false;
+	else
+		webm_end_chapter(&m_ebml, m_pts + m_duration);
+}
+
+//------------------------------------------------------------------
+unsigned int VPX_Interface::addTextTrack(const QString &name)
+{
+	if (m_frameNumber != 0 || !m_writer || !m_writer->isOpen())
+	{
+		qDebug() << "Text tracks must be added before encoding";
+		return 0;
+	}
+
+	const auto track = webm_add_subtitle_track(&m_ebml, name.toUtf8().constData());
+	if (track != 0)
+		m_texts.insert(track, QByteArray());
+
+	return track;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setText(const unsigned int track, const QString &text)
+{
+	if (m_texts.contains(track))
+		m_texts[track] = text.toUtf8();
+}
+
+//------------------------------------------------------------------
+bool VPX_Interface::setFrameIndex(const QString &fileName)
+{
+	if (m_frameNumber != 0 || m_indexWriter || !m_writer || !m_writer->isOpen())
+	{
+		qDebug() << "Frame index must be set once before encoding";
+		return false;
+	}
+
+	auto writer = std::make_unique<AsyncFileWriter>(fileName);
+	if (!writer->isOpen())
+	{
+		qDebug() << "failed to open file" << fileName;
+		return false;
+	}
+	writer->start();
+
+	FrameIndex::Header header;
+	memset(&header, 0, sizeof(FrameIndex::Header));
+	memcpy(header.magic, FrameIndex::MAGIC, sizeof(header.magic));
+	header.version    = FrameIndex::VERSION;
+	header.recordSize = sizeof(FrameIndex::Record);
+	header.fps        = static_cast<quint32>(m_fps);
+	writer->write(&header, sizeof(FrameIndex::Header));
+
+	m_indexWriter = std::move(writer);
+	m_indexFilename = fileName;
+
+	return true;
+}
+
+//------------------------------------------------------------------
+bool VPX_Interface::setThumbnails(const QString &fileName, const int interval, const int width)
+{
+	if (m_frameNumber != 0 || m_thumbnails || width < 2)
+	{
+		qDebug() << "Thumbnails must be set once before encoding";
+		return false;
+	}
+
+	const int height = width * static_cast<int>(m_vp8_config.g_h) / std::max(1, static_cast<int>(m_vp8_config.g_w));
+
+	m_thumbnails = std::make_unique<ThumbnailAtlas>(fileName, width, height);
+	m_thumbnails->start();
+	m_thumbnailInterval = std::max(1, interval);
+
+	return true;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setPomodoro(const unsigned int number)
+{
+	m_pomodoro = number;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setClusterChecksums(const bool enabled)
+{
+	if (m_frameNumber != 0)
+	{
+		qDebug() << "Cluster checksums must be set before encoding";
+		return;
+	}
+
+	m_ebml.cluster_crc = enabled ? 1 : 0;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setKeyFrames(const int maxDistance, const int sceneThreshold)
+{
+	if (m_frameNumber != 0)
+	{
+		qDebug() << "Keyframe placement must be set before encoding";
+		return;
+	}
+
+	m_sceneThreshold = std::clamp(sceneThreshold, 0, 100) / 100.;
+
+	m_vp8_config.kf_mode = m_sceneThreshold > 0 ? VPX_KF_DISABLED : VPX_KF_AUTO;
+	m_vp8_config.kf_max_dist = static_cast<unsigned int>(std::max(1, maxDistance));
+
+	if (vpx_codec_enc_config_set(&m_vp8_context, &m_vp8_config))
+		qDebug() << "Failed to set keyframe configuration" << QString(vpx_codec_error_detail(&m_vp8_context));
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setRegionsOfInterest(const QList<QRect> &regions, const int backgroundDeltaQ)
+{
+	// the encoder keeps the map between frames.
+	if (regions == m_roiRegions && backgroundDeltaQ == m_roiDeltaQ)
+		return;
+
+	m_roiRegions = regions;
+	m_roiDeltaQ = backgroundDeltaQ;
+
+	const int columns = (m_vp8_config.g_w + 15) / 16;
+	const int rows = (m_vp8_config.g_h + 15) / 16;
+
+	// the encoder checks the grid before the map, a null map with zeroed deltas disables the segmentation.
+	vpx_roi_map_t roi;
+	memset(&roi, 0, sizeof(vpx_roi_map_t));
+	roi.rows = static_cast<unsigned int>(rows);
+	roi.cols = static_cast<unsigned int>(columns);
+
+	if (!regions.isEmpty())
+	{
+		const double scaleX = static_cast<double>(m_vp8_config.g_w) / m_width;
+		const double scaleY = static_cast<double>(m_vp8_config.g_h) / m_height;
+
+		m_roiMap.assign(static_cast<size_t>(columns) * rows, BACKGROUND_SEGMENT);
+		for (const auto &region: regions)
+		{
+			const auto left = std::clamp(static_cast<int>(region.left() * scaleX) / 16, 0, columns);
+			const auto top = std::clamp(static_cast<int>(region.top() * scaleY) / 16, 0, rows);
+			const auto right = std::clamp((static_cast<int>((region.right() + 1) * scaleX) + 15) / 16, 0, columns);
+			const auto bottom = std::clamp((static_cast<int>((region.bottom() + 1) * scaleY) + 15) / 16, 0, rows);
+
+			for (int row = top; row < bottom; ++row)
+				memset(m_roiMap.data() + static_cast<size_t>(row) * columns + left, ROI_SEGMENT, std::max(0, right - left));
+		}
+
+		roi.roi_map = m_roiMap.data();
+		roi.delta_q[ROI_SEGMENT] = 0;
+		roi.delta_q[BACKGROUND_SEGMENT] = std::clamp(backgroundDeltaQ, 0, 63);
+	}
+
+	if (vpx_codec_control(&m_vp8_context, VP8E_SET_ROI_MAP, &roi))
+		qDebug() << "Failed to set the regions of interest" << QString(vpx_codec_error_detail(&m_vp8_context));
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setOverlays(const QList<I420Overlay::Sprite> &sprites)
+{
+	m_overlays = sprites;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setConstantFrameRate(const bool enabled)
+{
+	m_constantRate = enabled;
+}
+
+//------------------------------------------------------------------
+void VPX_Interface::setCaptureInterval(const qint64 milliseconds)
+{
+	m_captureInterval = std::max<qint64>(0, milliseconds);
+}
+
+//------------------------------------------------------------------
+long int VPX_Interface::computeFrameTime(const qint64 timestamp)
+{
+	if (m_frameNumber == 0)
+	{
+		m_startTime = timestamp;
+		m_pts = 0;
+		m_slot = 0;
+		m_duration = 1000 / m_fps;
+		return 0;
+	}
+
+	int64_t elapsed = std::max<int64_t>(0, timestamp - m_startTime);
+	if (m_captureInterval > 0)
+		elapsed = elapsed * 1000 / (m_captureInterval * m_fps);
+
+	if (!m_constantRate)
+	{
+		// the duration of a frame is known when the next one arrives, the last interval is the best guess.
+		const int64_t pts = std::max(elapsed, m_pts + 1);
+		m_duration = pts - m_pts;
+		m_pts = pts;
+		return 0;
+	}
+
+	const long int slot = static_cast<long int>((elapsed * m_fps + 500) / 1000);
+	if (slot <= m_slot)
+		return -1;
+
+	// long gaps are not filled with more than a second of repeated frames.
+	const long int missing = std::min<long int>(slot - m_slot - 1, m_fps);
+
+	m_slot = slot;
+	m_pts = static_cast<int64_t>(slot) * 1000 / m_fps;
+	m_duration = static_cast<int64_t>(slot + 1) * 1000 / m_fps - m_pts;
+
+	return missing;
+}
+
+//------------------------------------------------------------------
+QByteArray VPX_Interface::chapterTitle(const QString &title)
+{
+	// truncate by characters so the UTF-8 sequences remain valid.
+	auto text = title;
+	auto utf8 = text.toUtf8();
+	while (utf8.size() > WEBM_CHAPTER_TITLE_SIZE)
+	{
+		text.chop(1);
+		utf8 = text.toUtf8();
+	}
+
+	return utf8;
 }
 
 //------------------------------------------------------------------
@@ -29,13 +29,23 @@
 
 // Project
 #include "webmEBMLwriter.h"
+#include "AsyncFileWriter.h"
+#include "ThumbnailAtlas.h"
+#include "I420Overlay.h"
 
 // C++
 #include <stdio.h>
+#include <memory>
+#include <vector>
 
 // Qt
 #include <QString>
+#include <QByteArray>
 #include <QStack>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QList>
+#include <QRect>
 
 class QImage;
 
@@ -52,9 +62,12 @@ class VPX_Interface
      * \param[in] width width of the video in pixels.
      * \param[in] fps desired frames per second of the video.
      * \param[in] scaleRatio scale ratio from the initial size, value [0.5-2.0] default 1.0 (no rescaling)
+     * \param[in] durability sync to disk policy of the video file.
+     * \param[in] preallocation bytes of disk to preallocate for the video file, 0 to disable.
      *
      */
-		VPX_Interface(const QString fileName, const int height, const int width, const int fps, const float scaleRatio = 1.0);
+		VPX_Interface(const QString fileName, const int height, const int width, const int fps, const float scaleRatio = 1.0,
+		              const AsyncFileWriter::Durability durability = AsyncFileWriter::Durability::NONE, const qint64 preallocation = 0);
 
 		/** \brief VPX_Interface class virtual destructor.
 		 *
@@ -63,18 +76,188 @@ class VPX_Interface
 
 		/** \brief Encodes a frame to the video stream.
 		 * \param[in] frame raw pointer of the frame to encode.
+		 * \param[in] camera raw pointer of the camera frame to encode in the camera track, if enabled.
+		 * \param[in] timestamp capture time of the frame in milliseconds of a monotonic clock, or -1 to use
+		 *            the time of the call.
 		 *
 		 */
-		void encodeFrame(QImage *frame);
+		void encodeFrame(QImage *frame, const QImage *camera = nullptr, const qint64 timestamp = -1);
+
+		/** \brief Enables/disables the constant frame rate output. When enabled the frames are placed at
+		 *  multiples of the frame interval, repeating or dropping frames to follow the capture times. When
+		 *  disabled the frames keep their capture time (variable frame rate).
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setConstantFrameRate(const bool enabled);
+
+		/** \brief Sets the time between captures. The capture times are scaled so a capture interval lasts
+		 *  a frame of the video (time-lapse).
+		 * \param[in] milliseconds milliseconds between captures, 0 to keep the real time.
+		 *
+		 */
+		void setCaptureInterval(const qint64 milliseconds);
+
+		/** \brief Returns the size in bytes of the video file.
+		 *
+		 */
+		qint64 fileSize() const
+		{ return m_writer ? static_cast<qint64>(m_writer->size()) : 0; }
+
+		/** \brief Adds a second video track for the camera, encoded at its own resolution with a separate
+		 *  encoder. Must be called before encoding the first frame. Returns true on success.
+		 * \param[in] width width of the camera frames in pixels.
+		 * \param[in] height height of the camera frames in pixels.
+		 * \param[in] frameInterval number of desktop frames per camera frame.
+		 *
+		 */
+		bool setCameraTrack(const int width, const int height, const int frameInterval = 1);
+
+		/** \brief Sets the time between checkpoints of the video file. On a checkpoint the file
+		 *  is left in a valid and seekable state so it can be played if the application ends unexpectedly.
+		 * \param[in] minutes minutes between checkpoints, 0 to disable them.
+		 *
+		 */
+		void setCheckpointInterval(const int minutes);
+
+		/** \brief Starts a chapter with the given title at the next frame. The next frame is encoded
+		 *  as a keyframe so the chapter has a cue point.
+		 * \param[in] title chapter title.
+		 *
+		 */
+		void markChapter(const QString &title);
+
+		/** \brief Changes the title of the current chapter.
+		 * \param[in] title chapter title.
+		 *
+		 */
+		void setChapterTitle(const QString &title);
+
+		/** \brief Ends the current chapter at the time of the next frame.
+		 *
+		 */
+		void endChapter();
+
+		/** \brief Adds a subtitles track to the video. Must be called before encoding the first frame.
+		 *  Returns the track number or 0 on error.
+		 * \param[in] name track name.
+		 *
+		 */
+		unsigned int addTextTrack(const QString &name);
+
+		/** \brief Sets the text of the given subtitles track from the next frame on. The text is only
+		 *  written to the file when it changes, an empty text hides it.
+		 * \param[in] track track number.
+		 * \param[in] text track text.
+		 *
+		 */
+		void setText(const unsigned int track, const QString &text);
+
+		/** \brief Writes a sidecar index of the frames (see FrameIndex.h) to the given file. Must be called
+		 *  before encoding the first frame. Returns true on success.
+		 * \param[in] fileName name of the index file.
+		 *
+		 */
+		bool setFrameIndex(const QString &fileName);
+
+		/** \brief Sets the number of the pomodoro stored in the index entries of the next frames.
+		 * \param[in] number number of the pomodoro in the session, 0 if none.
+		 *
+		 */
+		void setPomodoro(const unsigned int number);
+
+		/** \brief Builds a contact sheet of the video with a thumbnail of every Nth frame, written when the
+		 *  video is closed. Must be called before encoding the first frame. Returns true on success.
+		 * \param[in] fileName name of the atlas image file, the offsets table has the same name with csv extension.
+		 * \param[in] interval number of frames between thumbnails.
+		 * \param[in] width width of the thumbnails in pixels, the height keeps the aspect ratio of the video.
+		 *
+		 */
+		bool setThumbnails(const QString &fileName, const int interval, const int width);
+
+		/** \brief Enables/disables a CRC-32 element in every cluster, computed by the writer thread when the
+		 *  cluster is closed. Must be called before encoding the first frame.
+		 * \param[in] enabled boolean value.
+		 *
+		 */
+		void setClusterChecksums(const bool enabled);
+
+		/** \brief Sets the keyframe placement of the desktop track. With scene detection the encoder doesn't place
+		 *  keyframes: they are forced on the frames that change more than the threshold and, when the maximum
+		 *  distance is reached, delayed until the desktop changes. Must be called before encoding the first frame.
+		 * \param[in] maxDistance maximum number of frames between keyframes.
+		 * \param[in] sceneThreshold percentage of the image that must change to force a keyframe, 0 to let the encoder decide.
+		 *
+		 */
+		void setKeyFrames(const int maxDistance, const int sceneThreshold);
+
+		/** \brief Sets the regions of the desktop image that keep the quality, the rest of the image is encoded with
+		 *  a coarser quantizer. The encoder map is only rebuilt when the regions change.
+		 * \param[in] regions rectangles in pixels of the desktop image, empty to encode all the image equally.
+		 * \param[in] backgroundDeltaQ quantizer delta of the macroblocks out of the regions [0,63].
+		 *
+		 */
+		void setRegionsOfInterest(const QList<QRect> &regions, const int backgroundDeltaQ);
+
+		/** \brief Sets the overlays to blend over the next frame once converted and scaled to the video size, so
+		 *  their cost depends on their area in the video instead of the desktop size.
+		 * \param[in] sprites overlays in desktop coordinates, in painting order.
+		 *
+		 */
+		void setOverlays(const QList<I420Overlay::Sprite> &sprites);
 
 	private:
 		static const int VP8_quality_values[3];
 
+		static constexpr int    SCENE_STEP         = 4;     /** distance in pixels between the samples of the scene metric. */
+		static constexpr int    SCENE_DIFFERENCE   = 24;    /** luma difference of a changed sample.                        */
+		static constexpr double STATIC_CHANGE      = 0.002; /** maximum change ratio of a static frame.                     */
+		static constexpr int    ROI_SEGMENT        = 0;     /** encoder segment of the regions of interest.                 */
+		static constexpr int    BACKGROUND_SEGMENT = 1;     /** encoder segment of the rest of the image.                   */
+
 		/** \brief Returns true if the image needs to be rescaled.
 		 *
 		 */
 		bool scalingEnabled() const;
 
+		/** \brief Computes the time and duration of the next frame from its capture time. Returns the
+		 *  number of missing frames before it in constant frame rate, or -1 if the frame must be dropped.
+		 * \param[in] timestamp capture time in milliseconds of a monotonic clock.
+		 *
+		 */
+		long int computeFrameTime(const qint64 timestamp);
+
+		/** \brief Returns the title in UTF-8 truncated to the maximum chapter title size.
+		 * \param[in] title chapter title.
+		 *
+		 */
+		static QByteArray chapterTitle(const QString &title);
+
+		/** \brief Returns the ratio [0,1] of the luma samples of the image that differ from the previous frame
+		 *  and keeps the samples for the next one.
+		 * \param[in] image image to encode.
+		 *
+		 */
+		double sceneChange(const vpx_image_t *image);
+
+		/** \brief Returns the flags to force a keyframe in the given image of the desktop track.
+		 * \param[in] image image to encode.
+		 *
+		 */
+		vpx_enc_frame_flags_t keyFrameFlags(const vpx_image_t *image);
+
+		/** \brief Encodes the image and writes the packets to the given track. Returns true if a keyframe has been written.
+		 * \param[in] context codec context.
+		 * \param[in] config codec configuration.
+		 * \param[in] image image to encode.
+		 * \param[in] pts time of the frame in timebase units.
+		 * \param[in] duration duration of the frame in timebase units.
+		 * \param[in] flags encoding flags.
+		 * \param[in] track track number.
+		 *
+		 */
+		bool encode(vpx_codec_ctx_t *context, const vpx_codec_enc_cfg_t *config, vpx_image_t *image, vpx_codec_pts_t pts, unsigned long duration, vpx_enc_frame_flags_t flags, unsigned int track);
+
 		vpx_image_t           m_vp8_rawImage;       /** vp8 frame image.                                  */
 		vpx_image_t           m_vp8_rawImageScaled; /** vp8 frame image scaled.                           */
 		vpx_codec_enc_cfg_t   m_vp8_config;         /** codec configuration                               */
@@ -87,8 +270,43 @@ class VPX_Interface
 		int                   m_hash;               /** murmur hash                                       */
 		long int              m_frameNumber;        /** number of the current frame.                      */
 		int                   m_fps;                /** video's frames per second                         */
+		bool                  m_constantRate;       /** true to resample the frames to a constant rate.   */
+		QElapsedTimer         m_clock;              /** clock of the frames without capture time.          */
+		qint64                m_startTime;          /** capture time of the first frame in milliseconds.  */
+		qint64                m_captureInterval;    /** milliseconds between captures, 0 for real time.   */
+		int64_t               m_pts;                /** time of the current frame in milliseconds.        */
+		int64_t               m_duration;           /** duration of the current frame in milliseconds.    */
+		long int              m_slot;               /** output frame number in constant frame rate.       */
+		qint64                m_checkpointInterval; /** milliseconds between checkpoints, 0 to disable.   */
+		QElapsedTimer         m_checkpointTimer;    /** time since the last checkpoint.                   */
+
+		vpx_image_t           m_camera_rawImage;    /** camera frame image.                               */
+		vpx_codec_enc_cfg_t   m_camera_config;      /** camera codec configuration.                       */
+		vpx_codec_ctx_t       m_camera_context;     /** camera codec context.                             */
+		unsigned int          m_cameraTrack;        /** camera track number, 0 if disabled.               */
+		int                   m_cameraInterval;     /** number of desktop frames per camera frame.        */
+		bool                  m_cameraKeyFrame;     /** true to force a keyframe in the next camera frame. */
+		bool                  m_chapterPending;     /** true to start a chapter at the next frame.        */
+		QString               m_chapterTitle;       /** title of the pending chapter.                     */
+		QMap<unsigned int, QByteArray> m_texts;     /** texts of the subtitles tracks.                    */
+		QString               m_indexFilename;      /** frame index file name, empty if disabled.         */
+		qint64                m_wallOffset;         /** wall-clock minus monotonic capture time in ms.    */
+		qint64                m_captureTime;        /** wall-clock capture time of the current frame.     */
+		unsigned int          m_pomodoro;           /** number of the current pomodoro, 0 if none.        */
+		int                   m_thumbnailInterval;  /** number of frames between thumbnails.              */
+		double                m_sceneThreshold;     /** change ratio that forces a keyframe, 0 if disabled. */
+		unsigned int          m_keyFrameDistance;   /** desktop frames since the last keyframe.           */
+		bool                  m_sceneChanged;       /** true if the scene changed since the last keyframe. */
+		std::vector<unsigned char> m_sceneSamples;  /** luma samples of the previous frame.               */
+		QList<QRect>          m_roiRegions;         /** regions of interest of the current map.           */
+		int                   m_roiDeltaQ;          /** quantizer delta of the background of the map.     */
+		std::vector<unsigned char> m_roiMap;        /** segment of each macroblock.                       */
+		QList<I420Overlay::Sprite> m_overlays;      /** overlays of the next frame.                       */
 
 		EbmlGlobal            m_ebml;               /** ebml structure (matroska's)                       */
+		std::unique_ptr<AsyncFileWriter> m_writer;  /** video file writer thread.                         */
+		std::unique_ptr<AsyncFileWriter> m_indexWriter; /** frame index file writer thread.               */
+		std::unique_ptr<ThumbnailAtlas>  m_thumbnails;  /** contact sheet thread, nullptr if disabled.     */
 };
 
 #endif /* VPX_INTERFACE_H_ */
@@ -0,0 +1,665 @@
+/*
+    File: WebMReader.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <WebMReader.h>
+#include <webmIDs.h>
+#include <Crc32.h>
+
+// Qt
+#include <QDebug>
+#include <QElapsedTimer>
+
+// C++
+#include <algorithm>
+#include <string.h>
+
+//------------------------------------------------------------------
+WebMReader::WebMReader(const QString &fileName)
+: m_file         {fileName}
+, m_data         {nullptr}
+, m_size         {0}
+, m_truncated    {false}
+, m_timecodeScale{1000000}
+, m_duration     {0}
+, m_throughput   {0}
+{
+}
+
+//------------------------------------------------------------------
+WebMReader::~WebMReader()
+{
+  if(m_data)
+  {
+    m_file.unmap(const_cast<uchar *>(m_data));
+  }
+}
+
+//------------------------------------------------------------------
+bool WebMReader::open()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  if(!m_file.open(QIODevice::ReadOnly))
+  {
+    m_error = QString("Unable to open file: %1").arg(m_file.errorString());
+    return false;
+  }
+
+  m_size = static_cast<quint64>(m_file.size());
+  m_data = m_file.map(0, m_file.size());
+  if(!m_data)
+  {
+    m_error = QString("Unable to map file: %1").arg(m_file.errorString());
+    return false;
+  }
+
+  Element header;
+  if(!readElement(m_data, 0, m_size, header) || header.id != EBML)
+  {
+    m_error = "Not an EBML file.";
+    return false;
+  }
+
+  quint64 position = header.dataOffset;
+  bool isWebM = false;
+  while(position < header.end())
+  {
+    Element child;
+    if(!readElement(m_data, position, header.end(), child) || child.truncated) break;
+
+    if(child.id == DocType)
+    {
+      const auto docType = QString::fromLatin1(reinterpret_cast<const char *>(m_data + child.dataOffset), static_cast<int>(child.size));
+      isWebM = (docType == "webm" || docType == "matroska");
+    }
+    position = child.end();
+  }
+
+  if(!isWebM)
+  {
+    m_error = "Not a WebM file.";
+    return false;
+  }
+
+  if(!readElement(m_data, header.end(), m_size, m_segment) || m_segment.id != Segment)
+  {
+    m_error = "Segment not found.";
+    return false;
+  }
+  m_truncated = m_segment.truncated;
+
+  position = m_segment.dataOffset;
+  while(position < m_segment.end())
+  {
+    Element element;
+    if(!readElement(m_data, position, m_segment.end(), element))
+    {
+      m_truncated = true;
+      break;
+    }
+
+    switch(element.id)
+    {
+      case Info:
+        parseInfo(element);
+        break;
+      case Tracks:
+        parseTracks(element);
+        break;
+      case Cues:
+        parseCues(element);
+        break;
+      case Chapters:
+        parseChapters(element);
+        break;
+      case wembIDs::Cluster:
+        position = parseCluster(element);
+        continue;
+      default:
+        break;
+    }
+
+    if(element.id != Void && isSegmentChild(element.id))
+    {
+      m_elements.push_back(element);
+    }
+
+    if(element.truncated)
+    {
+      m_truncated = true;
+      break;
+    }
+
+    // level 1 elements always have known size in the files we write.
+    position = element.end();
+  }
+
+  // the tracks are interleaved in the frames index, the keyframes are searched in each track list.
+  for(unsigned int i = 0; i < m_frames.size(); ++i)
+  {
+    if(m_frames[i].key) m_keyFrames[m_frames[i].track].push_back(i);
+  }
+
+  auto earlier = [this](const unsigned int a, const unsigned int b) { return m_frames[a].time < m_frames[b].time; };
+  for(auto &keyFrames: m_keyFrames)
+  {
+    std::stable_sort(keyFrames.second.begin(), keyFrames.second.end(), earlier);
+  }
+
+  const auto elapsed = timer.nsecsElapsed();
+  m_throughput = elapsed == 0 ? 0 : (static_cast<double>(m_size) / (1024. * 1024.)) / (elapsed / 1.0e9);
+
+  return true;
+}
+
+//------------------------------------------------------------------
+const WebMReader::Element *WebMReader::element(const unsigned int id) const
+{
+  auto it = std::find_if(m_elements.cbegin(), m_elements.cend(), [id](const Element &e) { return e.id == id; });
+
+  return it == m_elements.cend() ? nullptr : &(*it);
+}
+
+//------------------------------------------------------------------
+long long WebMReader::findKeyFrame(const unsigned int track, const qint64 time) const
+{
+  const auto keyFrames = m_keyFrames.find(track);
+  if(keyFrames == m_keyFrames.cend()) return -1;
+
+  // the first keyframe after the time, the previous one is the result.
+  const auto &indexes = keyFrames->second;
+  auto lessThan = [this](const qint64 value, const unsigned int index) { return value < m_frames[index].time; };
+  const auto it = std::upper_bound(indexes.cbegin(), indexes.cend(), time, lessThan);
+
+  return it == indexes.cbegin() ? -1 : static_cast<long long>(*std::prev(it));
+}
+
+//------------------------------------------------------------------
+bool WebMReader::readElement(const uchar *data, const quint64 position, const quint64 limit, Element &element)
+{
+  if(position >= limit) return false;
+
+  // id, the length marker is kept in the value.
+  const auto first = data[position];
+  int idLength = 1;
+  while(idLength <= 4 && !(first & (0x80 >> (idLength - 1)))) ++idLength;
+  if(idLength > 4 || position + idLength > limit) return false;
+
+  unsigned int id = 0;
+  for(int i = 0; i < idLength; ++i) id = (id << 8) | data[position + i];
+
+  // size, unknown if all the value bits are set.
+  const auto sizePosition = position + idLength;
+  if(sizePosition >= limit) return false;
+
+  const auto sizeFirst = data[sizePosition];
+  int sizeLength = 1;
+  while(sizeLength <= 8 && !(sizeFirst & (0x80 >> (sizeLength - 1)))) ++sizeLength;
+  if(sizeLength > 8 || sizePosition + sizeLength > limit) return false;
+
+  const unsigned char mask = 0xFF >> sizeLength;
+  quint64 size = sizeFirst & mask;
+  bool unknown = (size == mask);
+  for(int i = 1; i < sizeLength; ++i)
+  {
+    size = (size << 8) | data[sizePosition + i];
+    unknown &= (data[sizePosition + i] == 0xFF);
+  }
+
+  element.id         = id;
+  element.offset     = position;
+  element.dataOffset = sizePosition + sizeLength;
+  element.unknown    = unknown;
+  element.truncated  = false;
+
+  if(unknown)
+  {
+    element.size = limit - element.dataOffset;
+  }
+  else
+  {
+    element.size = size;
+    if(element.dataOffset + size > limit)
+    {
+      element.size = limit - element.dataOffset;
+      element.truncated = true;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------
+quint64 WebMReader::readUnsigned(const uchar *data, const Element &element)
+{
+  quint64 value = 0;
+  for(quint64 i = 0; i < std::min<quint64>(element.size, 8); ++i)
+  {
+    value = (value << 8) | data[element.dataOffset + i];
+  }
+
+  return value;
+}
+
+//------------------------------------------------------------------
+double WebMReader::readFloat(const uchar *data, const Element &element)
+{
+  const auto value = readUnsigned(data, element);
+
+  if(element.size == 4)
+  {
+    const auto bits = static_cast<quint32>(value);
+    float result;
+    ::memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+
+  if(element.size == 8)
+  {
+    double result;
+    ::memcpy(&result, &value, sizeof(result));
+    return result;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------
+bool WebMReader::isSegmentChild(const unsigned int id)
+{
+  switch(id)
+  {
+    case SeekHead:
+    case Info:
+    case Tracks:
+    case wembIDs::Cluster:
+    case Cues:
+    case Chapters:
+    case Tags:
+    case Attachments:
+    case Void:
+      return true;
+    default:
+      break;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------
+void WebMReader::parseInfo(const Element &element)
+{
+  double duration = 0;
+  quint64 position = element.dataOffset;
+  while(position < element.end())
+  {
+    Element child;
+    if(!readElement(m_data, position, element.end(), child) || child.truncated) break;
+
+    switch(child.id)
+    {
+      case TimecodeScale:
+        m_timecodeScale = readUnsigned(m_data, child);
+        break;
+      case Segment_Duration:
+        duration = readFloat(m_data, child);
+        break;
+      default:
+        break;
+    }
+    position = child.end();
+  }
+
+  m_duration = duration * m_timecodeScale / 1000000.;
+}
+
+//------------------------------------------------------------------
+void WebMReader::parseTracks(const Element &element)
+{
+  quint64 position = element.dataOffset;
+  while(position < element.end())
+  {
+    Element entry;
+    if(!readElement(m_data, position, element.end(), entry) || entry.truncated) break;
+
+    if(entry.id == TrackEntry)
+    {
+      Track track;
+
+      quint64 entryPosition = entry.dataOffset;
+      while(entryPosition < entry.end())
+      {
+        Element child;
+        if(!readElement(m_data, entryPosition, entry.end(), child) || child.truncated) break;
+
+        switch(child.id)
+        {
+          case TrackNumber:
+            track.number = static_cast<unsigned int>(readUnsigned(m_data, child));
+            break;
+          case TrackUID:
+            track.uid = readUnsigned(m_data, child);
+            break;
+          case TrackType:
+            track.type = static_cast<unsigned int>(readUnsigned(m_data, child));
+            break;
+          case CodecID:
+            track.codec = QString::fromLatin1(reinterpret_cast<const char *>(m_data + child.dataOffset), static_cast<int>(child.size));
+            break;
+          case Name:
+            track.name = QString::fromUtf8(reinterpret_cast<const char *>(m_data + child.dataOffset), static_cast<int>(child.size));
+            break;
+          case Video:
+            {
+              quint64 videoPosition = child.dataOffset;
+              while(videoPosition < child.end())
+              {
+                Element value;
+                if(!readElement(m_data, videoPosition, child.end(), value) || value.truncated) break;
+
+                if(value.id == PixelWidth)  track.width  = static_cast<unsigned int>(readUnsigned(m_data, value));
+                if(value.id == PixelHeight) track.height = static_cast<unsigned int>(readUnsigned(m_data, value));
+
+                videoPosition = value.end();
+              }
+            }
+            break;
+          default:
+            break;
+        }
+        entryPosition = child.end();
+      }
+
+      m_tracks.push_back(track);
+    }
+    position = entry.end();
+  }
+}
+
+//------------------------------------------------------------------
+void WebMReader::parseCues(const Element &element)
+{
+  quint64 position = element.dataOffset;
+  while(position < element.end())
+  {
+    Element point;
+    if(!readElement(m_data, position, element.end(), point) || point.truncated) break;
+
+    if(point.id == CuePoint)
+    {
+      Cue cue;
+
+      quint64 pointPosition = point.dataOffset;
+      while(pointPosition < point.end())
+      {
+        Element child;
+        if(!readElement(m_data, pointPosition, point.end(), child) || child.truncated) break;
+
+        if(child.id == CueTime)
+        {
+          cue.time = static_cast<qint64>(readUnsigned(m_data, child) * m_timecodeScale / 1000000);
+        }
+        else if(child.id == CueTrackPositions)
+        {
+          quint64 trackPosition = child.dataOffset;
+          while(trackPosition < child.end())
+          {
+            Element value;
+            if(!readElement(m_data, trackPosition, child.end(), value) || value.truncated) break;
+
+            if(value.id == CueTrack)           cue.track    = static_cast<unsigned int>(readUnsigned(m_data, value));
+            if(value.id == CueClusterPosition) cue.position = m_segment.dataOffset + readUnsigned(m_data, value);
+
+            trackPosition = value.end();
+          }
+        }
+        pointPosition = child.end();
+      }
+
+      m_cues.push_back(cue);
+    }
+    position = point.end();
+  }
+}
+
+//------------------------------------------------------------------
+void WebMReader::parseChapters(const Element &element)
+{
+  Element edition;
+  if(!readElement(m_data, element.dataOffset, element.end(), edition) || edition.truncated || edition.id != EditionEntry) return;
+
+  quint64 position = edition.dataOffset;
+  while(position < edition.end())
+  {
+    Element atom;
+    if(!readElement(m_data, position, edition.end(), atom) || atom.truncated) break;
+
+    if(atom.id == ChapterAtom)
+    {
+      Chapter chapter;
+      chapter.end = -1;
+
+      quint64 atomPosition = atom.dataOffset;
+      while(atomPosition < atom.end())
+      {
+        Element child;
+        if(!readElement(m_data, atomPosition, atom.end(), child) || child.truncated) break;
+
+        switch(child.id)
+        {
+          case ChapterTimeStart:
+            chapter.start = static_cast<qint64>(readUnsigned(m_data, child) / 1000000);
+            break;
+          case ChapterTimeEnd:
+            chapter.end = static_cast<qint64>(readUnsigned(m_data, child) / 1000000);
+            break;
+          case ChapterDisplay:
+            {
+              Element value;
+              if(readElement(m_data, child.dataOffset, child.end(), value) && !value.truncated && value.id == ChapString)
+              {
+                chapter.title = QString::fromUtf8(reinterpret_cast<const char *>(m_data + value.dataOffset), static_cast<int>(value.size));
+              }
+            }
+            break;
+          default:
+            break;
+        }
+        atomPosition = child.end();
+      }
+
+      m_chapters.push_back(chapter);
+    }
+    position = atom.end();
+  }
+}
+
+//------------------------------------------------------------------
+quint64 WebMReader::parseCluster(const Element &element)
+{
+  Cluster cluster;
+  cluster.element = element;
+
+  const auto clusterIndex = static_cast<unsigned int>(m_clusters.size());
+
+  quint64 position = element.dataOffset;
+  while(position < element.end())
+  {
+    Element child;
+    if(!readElement(m_data, position, element.end(), child))
+    {
+      m_truncated = true;
+      break;
+    }
+
+    // clusters of unknown size end where the next level 1 element starts.
+    if(element.unknown && isSegmentChild(child.id) && child.id != Void)
+    {
+      break;
+    }
+
+    if(child.truncated)
+    {
+      m_truncated = true;
+      position = element.end();
+      break;
+    }
+
+    switch(child.id)
+    {
+      case Timecode:
+        cluster.timecode = readUnsigned(m_data, child) * m_timecodeScale / 1000000;
+        break;
+      case CRC_32:
+        // only valid as the first element, the value is stored in little endian.
+        if(child.offset == element.dataOffset && child.size == 4)
+        {
+          const auto value = m_data + child.dataOffset;
+          cluster.hasCrc = true;
+          cluster.crc    = value[0] | (value[1] << 8) | (value[2] << 16) | (static_cast<quint32>(value[3]) << 24);
+          cluster.crcEnd = child.end();
+        }
+        break;
+      case SimpleBlock:
+        {
+          Frame frame;
+          frame.block   = child.offset;
+          frame.cluster = clusterIndex;
+          if(parseBlock(child, true, frame))
+          {
+            frame.time += cluster.timecode;
+            m_frames.push_back(frame);
+          }
+        }
+        break;
+      case BlockGroup:
+        {
+          Frame frame;
+          frame.block   = child.offset;
+          frame.cluster = clusterIndex;
+          frame.key     = true;
+          bool valid    = false;
+
+          quint64 groupPosition = child.dataOffset;
+          while(groupPosition < child.end())
+          {
+            Element value;
+            if(!readElement(m_data, groupPosition, child.end(), value) || value.truncated) break;
+
+            switch(value.id)
+            {
+              case Block:
+                valid = parseBlock(value, false, frame);
+                break;
+              case BlockDuration:
+                frame.duration = static_cast<qint64>(readUnsigned(m_data, value) * m_timecodeScale / 1000000);
+                break;
+              case ReferenceBlock:
+                frame.key = false;
+                break;
+              default:
+                break;
+            }
+            groupPosition = value.end();
+          }
+
+          if(valid)
+          {
+            frame.time += cluster.timecode;
+            m_frames.push_back(frame);
+          }
+        }
+        break;
+      default:
+        break;
+    }
+
+    position = child.end();
+  }
+
+  cluster.element.size = position - element.dataOffset;
+  m_clusters.push_back(cluster);
+
+  return position;
+}
+
+//------------------------------------------------------------------
+std::vector<unsigned int> WebMReader::verify() const
+{
+  std::vector<unsigned int> damaged;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  quint64 checked = 0;
+  for(unsigned int i = 0; i < m_clusters.size(); ++i)
+  {
+    const auto &cluster = m_clusters.at(i);
+    if(!cluster.hasCrc) continue;
+
+    // truncated clusters are checked up to the data parsed, the checksum won't match.
+    const auto length = cluster.element.end() - cluster.crcEnd;
+    if(crc32(m_data + cluster.crcEnd, length) != cluster.crc)
+    {
+      damaged.push_back(i);
+    }
+
+    checked += length;
+  }
+
+  const auto elapsed = timer.nsecsElapsed();
+  qDebug() << "Verified" << checked << "bytes in" << elapsed / 1000000 << "ms," << damaged.size() << "damaged clusters.";
+
+  return damaged;
+}
+
+//------------------------------------------------------------------
+bool WebMReader::parseBlock(const Element &element, const bool simple, Frame &frame)
+{
+  // track number vint, signed 16 bits relative timecode and flags.
+  if(element.size < 4) return false;
+
+  const auto first = m_data[element.dataOffset];
+  int length = 1;
+  while(length <= 8 && !(first & (0x80 >> (length - 1)))) ++length;
+  if(length > 8 || static_cast<quint64>(length + 3) > element.size) return false;
+
+  quint64 track = first & (0xFF >> length);
+  for(int i = 1; i < length; ++i) track = (track << 8) | m_data[element.dataOffset + i];
+
+  const auto header = element.dataOffset + length;
+  const auto timecode = static_cast<qint16>((m_data[header] << 8) | m_data[header + 1]);
+  const auto flags = m_data[header + 2];
+
+  frame.track  = static_cast<unsigned int>(track);
+  frame.time   = static_cast<qint64>(timecode) * static_cast<qint64>(m_timecodeScale) / 1000000;
+  frame.offset = header + 3;
+  frame.size   = element.end() - frame.offset;
+
+  // laced blocks are indexed as a single frame, we don't write them.
+  if(simple)
+  {
+    frame.key = (flags & 0x80) != 0;
+  }
+  frame.invisible = (flags & 0x08) != 0;
+
+  return true;
+}
@@ -0,0 +1,335 @@
+/*
+    File: WebMReader.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEBM_READER_H_
+#define WEBM_READER_H_
+
+// Qt
+#include <QFile>
+#include <QString>
+
+// C++
+#include <map>
+#include <vector>
+
+/** \class WebMReader
+ *  \brief Memory-mapped parser of WebM files. Walks the Segment, Clusters and Cues and builds
+ *         an index of the frames without copying their data. Files with unknown size elements
+ *         (checkpointed or unfinished files) and truncated files are accepted, the index contains
+ *         the complete frames found.
+ *
+ */
+class WebMReader
+{
+  public:
+    /** \struct Element
+     * \brief Position of an EBML element in the file.
+     */
+    struct Element
+    {
+      unsigned int id         = 0;     /** element id.                                          */
+      quint64      offset     = 0;     /** position of the element id in the file.              */
+      quint64      dataOffset = 0;     /** position of the element data in the file.            */
+      quint64      size       = 0;     /** size of the data in the file.                       */
+      bool         unknown    = false; /** true if the element has unknown size.               */
+      bool         truncated  = false; /** true if the data exceeds the end of the parent/file. */
+
+      /** \brief Returns the position after the element data.
+       *
+       */
+      quint64 end() const
+      { return dataOffset + size; }
+    };
+
+    /** \struct Track
+     * \brief Track information.
+     */
+    struct Track
+    {
+      unsigned int number = 0; /** track number.                        */
+      quint64      uid    = 0; /** track unique identifier.              */
+      unsigned int type   = 0; /** track type, 1 video, 0x11 subtitles. */
+      QString      codec;      /** codec id.                             */
+      QString      name;       /** track name, empty if none.            */
+      unsigned int width  = 0; /** width in pixels of video tracks.      */
+      unsigned int height = 0; /** height in pixels of video tracks.     */
+    };
+
+    /** \struct Frame
+     * \brief Entry of the frames index.
+     */
+    struct Frame
+    {
+      unsigned int track    = 0;     /** track number.                                          */
+      qint64       time     = 0;     /** presentation time in milliseconds.                    */
+      qint64       duration = 0;     /** duration in milliseconds, only set for BlockGroups.    */
+      quint64      offset   = 0;     /** position of the frame data in the file.               */
+      quint64      size     = 0;     /** size of the frame data in bytes.                     */
+      quint64      block    = 0;     /** position of the SimpleBlock/BlockGroup in the file.   */
+      unsigned int cluster  = 0;     /** index of the cluster of the frame.                    */
+      bool         key      = false; /** true if the frame is a keyframe.                      */
+      bool         invisible = false; /** true if the frame is not shown.                       */
+    };
+
+    /** \struct Cluster
+     * \brief Cluster information.
+     */
+    struct Cluster
+    {
+      Element element;          /** cluster element.                                              */
+      quint64 timecode = 0;     /** cluster timecode in milliseconds.                             */
+      bool    hasCrc   = false; /** true if the cluster starts with a CRC-32 element.             */
+      quint32 crc      = 0;     /** stored CRC-32 of the cluster data.                            */
+      quint64 crcEnd   = 0;     /** position after the CRC-32 element, start of the checked data. */
+    };
+
+    /** \struct Cue
+     * \brief Cue point information.
+     */
+    struct Cue
+    {
+      qint64       time     = 0; /** time in milliseconds.                */
+      unsigned int track    = 0; /** track number.                        */
+      quint64      position = 0; /** position of the cluster in the file. */
+    };
+
+    /** \struct Chapter
+     * \brief Chapter information.
+     */
+    struct Chapter
+    {
+      qint64  start = 0; /** start time in milliseconds.            */
+      qint64  end   = 0; /** end time in milliseconds, -1 if not set. */
+      QString title;     /** chapter title.                          */
+    };
+
+    /** \brief WebMReader class constructor.
+     * \param[in] fileName name of the file to read.
+     *
+     */
+    explicit WebMReader(const QString &fileName);
+
+    /** \brief WebMReader class virtual destructor.
+     *
+     */
+    virtual ~WebMReader();
+
+    /** \brief Maps the file and parses it. Returns true on success and false otherwise.
+     *
+     */
+    bool open();
+
+    /** \brief Returns the description of the last error, empty if none.
+     *
+     */
+    QString error() const
+    { return m_error; }
+
+    /** \brief Returns true if the file ends before the end of the data.
+     *
+     */
+    bool isTruncated() const
+    { return m_truncated; }
+
+    /** \brief Returns the size of the file in bytes.
+     *
+     */
+    quint64 size() const
+    { return m_size; }
+
+    /** \brief Returns the mapped data of the file.
+     *
+     */
+    const uchar *data() const
+    { return m_data; }
+
+    /** \brief Returns the data of the given frame. The pointer is valid while the reader exists.
+     * \param[in] frame frame index entry.
+     *
+     */
+    const uchar *frameData(const Frame &frame) const
+    { return m_data + frame.offset; }
+
+    /** \brief Returns the Segment element.
+     *
+     */
+    const Element &segment() const
+    { return m_segment; }
+
+    /** \brief Returns the level 1 elements of the segment, except the clusters.
+     *
+     */
+    const std::vector<Element> &elements() const
+    { return m_elements; }
+
+    /** \brief Returns the first level 1 element with the given id, or nullptr if not found.
+     * \param[in] id element id.
+     *
+     */
+    const Element *element(const unsigned int id) const;
+
+    /** \brief Returns the tracks of the file.
+     *
+     */
+    const std::vector<Track> &tracks() const
+    { return m_tracks; }
+
+    /** \brief Returns the frames index in file order.
+     *
+     */
+    const std::vector<Frame> &frames() const
+    { return m_frames; }
+
+    /** \brief Returns the clusters in file order.
+     *
+     */
+    const std::vector<Cluster> &clusters() const
+    { return m_clusters; }
+
+    /** \brief Returns the cue points of the file.
+     *
+     */
+    const std::vector<Cue> &cues() const
+    { return m_cues; }
+
+    /** \brief Returns the chapters of the file.
+     *
+     */
+    const std::vector<Chapter> &chapters() const
+    { return m_chapters; }
+
+    /** \brief Returns the duration in milliseconds stored in the segment information.
+     *
+     */
+    double duration() const
+    { return m_duration; }
+
+    /** \brief Returns the timecode scale in nanoseconds.
+     *
+     */
+    quint64 timecodeScale() const
+    { return m_timecodeScale; }
+
+    /** \brief Returns the index of the last keyframe of the track with time less or equal than the given one, or -1 if none.
+     * \param[in] track track number.
+     * \param[in] time time in milliseconds.
+     *
+     */
+    long long findKeyFrame(const unsigned int track, const qint64 time) const;
+
+    /** \brief Checks the CRC-32 of the clusters that have one and returns the indexes of the damaged
+     *  clusters. Clusters without CRC-32 element are not checked.
+     *
+     */
+    std::vector<unsigned int> verify() const;
+
+    /** \brief Returns the parsing throughput of the last open() in MB/s.
+     *
+     */
+    double throughput() const
+    { return m_throughput; }
+
+    /** \brief Reads the EBML element header at the given position. Returns false if it's not a valid
+     *  header or it ends after the given limit.
+     * \param[in] data file data.
+     * \param[in] position position of the element.
+     * \param[in] limit end of the parent element.
+     * \param[out] element element information.
+     *
+     */
+    static bool readElement(const uchar *data, const quint64 position, const quint64 limit, Element &element);
+
+    /** \brief Returns the value of an unsigned integer element.
+     * \param[in] data file data.
+     * \param[in] element element information.
+     *
+     */
+    static quint64 readUnsigned(const uchar *data, const Element &element);
+
+    /** \brief Returns the value of a float element.
+     * \param[in] data file data.
+     * \param[in] element element information.
+     *
+     */
+    static double readFloat(const uchar *data, const Element &element);
+
+    /** \brief Returns true if the id is one of the level 1 elements of a segment.
+     * \param[in] id element id.
+     *
+     */
+    static bool isSegmentChild(const unsigned int id);
+
+  private:
+    /** \brief Parses the segment information.
+     * \param[in] element Info element.
+     *
+     */
+    void parseInfo(const Element &element);
+
+    /** \brief Parses the tracks.
+     * \param[in] element Tracks element.
+     *
+     */
+    void parseTracks(const Element &element);
+
+    /** \brief Parses the cues.
+     * \param[in] element Cues element.
+     *
+     */
+    void parseCues(const Element &element);
+
+    /** \brief Parses the chapters of the first edition.
+     * \param[in] element Chapters element.
+     *
+     */
+    void parseChapters(const Element &element);
+
+    /** \brief Parses a cluster and returns the position after it.
+     * \param[in] element Cluster element.
+     *
+     */
+    quint64 parseCluster(const Element &element);
+
+    /** \brief Parses a block and adds it to the frames index. Returns false if the block is not valid.
+     * \param[in] element SimpleBlock or Block element.
+     * \param[in] simple true if the element is a SimpleBlock.
+     * \param[out] frame frame information.
+     *
+     */
+    bool parseBlock(const Element &element, const bool simple, Frame &frame);
+
+    QFile                m_file;          /** mapped file.                                  */
+    const uchar         *m_data;          /** mapped data.                                  */
+    quint64              m_size;          /** size of the file.                             */
+    QString              m_error;         /** last error description.                       */
+    bool                 m_truncated;     /** true if the file ends before the data.        */
+    Element              m_segment;       /** segment element.                              */
+    std::vector<Element> m_elements;      /** level 1 elements except clusters.             */
+    std::vector<Track>   m_tracks;        /** tracks list.                                  */
+    std::vector<Frame>   m_frames;        /** frames index.                                 */
+    std::map<unsigned int, std::vector<unsigned int>> m_keyFrames; /** keyframe indexes of each track in time order. */
+    std::vector<Cluster> m_clusters;      /** clusters list.                                */
+    std::vector<Cue>     m_cues;          /** cue points.                                   */
+    std::vector<Chapter> m_chapters;      /** chapters.                                     */
+    quint64              m_timecodeScale; /** timecode scale in nanoseconds.                */
+    double               m_duration;      /** duration in milliseconds.                     */
+    double               m_throughput;    /** parsing throughput of the last open in MB/s.  */
+};
+
+#endif // WEBM_READER_H_
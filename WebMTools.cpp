@@ -0,0 +1,748 @@
+/*
+    File: WebMTools.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <WebMTools.h>
+#include <WebMReader.h>
+#include <AsyncFileWriter.h>
+#include <webmEBMLwriter.h>
+#include <webmIDs.h>
+
+// Qt
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFile>
+
+// C++
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <string.h>
+
+namespace
+{
+  /** \brief Returns true if the tracks can be written by our muxer.
+   * \param[in] tracks tracks of a file.
+   *
+   */
+  bool supportedTracks(const std::vector<WebMReader::Track> &tracks)
+  {
+    if(tracks.empty() || tracks.size() > WEBM_MAX_TRACKS) return false;
+
+    for(unsigned int i = 0; i < tracks.size(); ++i)
+    {
+      const auto &track = tracks.at(i);
+      if(track.number != i + 1) return false;
+
+      const bool video    = (track.type == WEBM_TRACK_VIDEO && track.codec == "V_VP8");
+      const bool subtitle = (track.type == WEBM_TRACK_SUBTITLE && track.codec == "D_WEBVTT/SUBTITLES");
+      if(!video && !subtitle) return false;
+    }
+
+    return true;
+  }
+
+  /** \brief Returns true if both files have the same tracks.
+   * \param[in] a tracks of the first file.
+   * \param[in] b tracks of the second file.
+   *
+   */
+  bool sameTracks(const std::vector<WebMReader::Track> &a, const std::vector<WebMReader::Track> &b)
+  {
+    if(a.size() != b.size()) return false;
+
+    for(unsigned int i = 0; i < a.size(); ++i)
+    {
+      if(a.at(i).type != b.at(i).type || a.at(i).codec != b.at(i).codec || a.at(i).width != b.at(i).width || a.at(i).height != b.at(i).height)
+        return false;
+    }
+
+    return true;
+  }
+
+  /** \brief Returns the end time of the file in milliseconds, the segment duration or the end of the
+   *  last frame if the duration was not written.
+   * \param[in] reader file reader.
+   *
+   */
+  qint64 fileEnd(const WebMReader &reader)
+  {
+    auto end = static_cast<qint64>(reader.duration());
+    for(const auto &frame: reader.frames())
+    {
+      end = std::max(end, frame.time + std::max<qint64>(frame.duration, 1));
+    }
+
+    return end;
+  }
+
+  /** \brief Returns the frame rate of the first track estimated from the times of its frames.
+   * \param[in] reader file reader.
+   *
+   */
+  int frameRate(const WebMReader &reader)
+  {
+    qint64 first = -1, last = -1;
+    long long count = 0;
+    for(const auto &frame: reader.frames())
+    {
+      if(frame.track != 1) continue;
+      if(first == -1) first = frame.time;
+      last = frame.time;
+      ++count;
+    }
+
+    if(count < 2 || last <= first) return 15;
+
+    return std::max(1, static_cast<int>((count - 1) * 1000 / (last - first)));
+  }
+
+  /** \struct RepairCluster
+   * \brief Cluster found while scanning a damaged file.
+   */
+  struct RepairCluster
+  {
+    quint64 offset   = 0;     /** position of the cluster element.                               */
+    quint64 end      = 0;     /** position after the last complete child of the cluster.          */
+    quint64 timecode = 0;     /** cluster timecode in milliseconds.                               */
+    quint64 crc      = 0;     /** position of the CRC-32 element, 0 if none.                      */
+    bool    patch    = false; /** true if the size must be rewritten (unknown or wrong size).     */
+    bool    cue      = false; /** true if the cluster starts with a keyframe of the first track. */
+  };
+
+  /** \struct RepairText
+   * \brief Subtitle cue without duration, open when the recording stopped.
+   */
+  struct RepairText
+  {
+    quint64      position = 0; /** position of the BlockDuration element.  */
+    qint64       start    = 0; /** start time of the cue in milliseconds.   */
+    unsigned int cluster  = 0; /** index of the cluster of the cue.        */
+  };
+
+  /** \brief Reads the track number, relative timecode and flags of a block. Returns false if the
+   *  header is not valid.
+   * \param[in] data file data.
+   * \param[in] element SimpleBlock or Block element.
+   * \param[out] track track number.
+   * \param[out] timecode timecode relative to the cluster.
+   * \param[out] flags block flags.
+   *
+   */
+  bool readBlockHeader(const uchar *data, const WebMReader::Element &element, unsigned int &track, qint16 &timecode, uchar &flags)
+  {
+    if(element.size < 4 || !(data[element.dataOffset] & 0x80)) return false;
+
+    // our track numbers always fit in one byte.
+    const auto header = element.dataOffset + 1;
+    track    = data[element.dataOffset] & 0x7F;
+    timecode = static_cast<qint16>((data[header] << 8) | data[header + 1]);
+    flags    = data[header + 2];
+
+    return true;
+  }
+
+  /** \brief Returns true if there is a cluster with an 8 bytes size followed by its timecode, after
+   *  the optional CRC-32 element, at the given position.
+   * \param[in] data file data.
+   * \param[in] position position of the candidate cluster.
+   * \param[in] limit end of the data.
+   * \param[out] timecode cluster timecode.
+   *
+   */
+  bool readClusterHeader(const uchar *data, const quint64 position, const quint64 limit, quint64 &timecode)
+  {
+    WebMReader::Element cluster, child;
+    if(!WebMReader::readElement(data, position, limit, cluster) || cluster.id != Cluster || cluster.dataOffset != position + 12) return false;
+    if(!WebMReader::readElement(data, cluster.dataOffset, limit, child) || child.truncated) return false;
+    if(child.id == CRC_32 && (child.size != 4 || !WebMReader::readElement(data, child.end(), limit, child) || child.truncated)) return false;
+    if(child.id != Timecode || child.size > 8) return false;
+
+    timecode = WebMReader::readUnsigned(data, child);
+    return true;
+  }
+
+  /** \brief Returns the position of the next cluster after the given position with a timecode not
+   *  less than the given one, or 0 if none is found.
+   * \param[in] data file data.
+   * \param[in] position start of the search.
+   * \param[in] limit end of the data.
+   * \param[in] minimum minimum cluster timecode.
+   *
+   */
+  quint64 findCluster(const uchar *data, quint64 position, const quint64 limit, const quint64 minimum)
+  {
+    static const uchar clusterId[4] = { 0x1F, 0x43, 0xB6, 0x75 };
+
+    while(position + sizeof(clusterId) <= limit)
+    {
+      const auto found = static_cast<const uchar *>(::memchr(data + position, clusterId[0], limit - position));
+      if(!found) break;
+
+      position = static_cast<quint64>(found - data);
+      quint64 timecode = 0;
+      if(position + sizeof(clusterId) <= limit && ::memcmp(found, clusterId, sizeof(clusterId)) == 0 &&
+         readClusterHeader(data, position, limit, timecode) && timecode >= minimum)
+      {
+        return position;
+      }
+
+      ++position;
+    }
+
+    return 0;
+  }
+
+  /** \brief Scans the children of a cluster until the end of the cluster or the first damaged or
+   *  incomplete one.
+   * \param[in] data file data.
+   * \param[in] element Cluster element.
+   * \param[in] index index of the cluster.
+   * \param[out] cluster cluster information.
+   * \param[out] texts subtitle cues without duration.
+   * \param[in,out] lastTime time of the last video frame.
+   * \param[in,out] interval time between the last two video frames.
+   *
+   */
+  void scanCluster(const uchar *data, const WebMReader::Element &element, const unsigned int index, RepairCluster &cluster,
+                   std::vector<RepairText> &texts, qint64 &lastTime, qint64 &interval)
+  {
+    cluster.offset = element.offset;
+
+    bool first = true;
+    quint64 position = element.dataOffset;
+    while(position < element.end())
+    {
+      WebMReader::Element child;
+      if(!WebMReader::readElement(data, position, element.end(), child) || child.truncated) break;
+
+      // clusters of unknown size end where the next level 1 element starts.
+      if(element.unknown && WebMReader::isSegmentChild(child.id) && child.id != Void) break;
+
+      unsigned int track = 0;
+      qint16 timecode = 0;
+      uchar flags = 0;
+      bool valid = true;
+
+      switch(child.id)
+      {
+        case Timecode:
+          cluster.timecode = WebMReader::readUnsigned(data, child);
+          break;
+        case CRC_32:
+          if(child.offset == element.dataOffset && child.size == 4) cluster.crc = child.offset;
+          break;
+        case SimpleBlock:
+          valid = readBlockHeader(data, child, track, timecode, flags);
+          if(valid && first)
+          {
+            cluster.cue = (track == 1 && (flags & 0x80));
+          }
+          first = false;
+          break;
+        case BlockGroup:
+          {
+            quint64 durationPosition = 0;
+            quint64 groupPosition = child.dataOffset;
+            valid = false;
+            while(groupPosition < child.end())
+            {
+              WebMReader::Element value;
+              if(!WebMReader::readElement(data, groupPosition, child.end(), value) || value.truncated) break;
+
+              if(value.id == Block) valid = readBlockHeader(data, value, track, timecode, flags);
+              if(value.id == BlockDuration && value.size == 8 && WebMReader::readUnsigned(data, value) == 0) durationPosition = value.offset;
+
+              groupPosition = value.end();
+            }
+
+            if(valid && durationPosition != 0)
+            {
+              texts.push_back(RepairText{durationPosition, static_cast<qint64>(cluster.timecode) + timecode, index});
+            }
+            first = false;
+          }
+          break;
+        default:
+          break;
+      }
+
+      if(!valid) break;
+
+      const auto time = static_cast<qint64>(cluster.timecode) + timecode;
+      if(track == 1 && time > lastTime)
+      {
+        if(lastTime >= 0) interval = time - lastTime;
+        lastTime = time;
+      }
+
+      position = child.end();
+    }
+
+    cluster.end   = position;
+    cluster.patch = element.unknown || element.truncated || position != element.end();
+  }
+}
+
+//------------------------------------------------------------------
+bool WebMTools::concatenate(const QStringList &inputs, const QString &output, QString &error)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  if(inputs.isEmpty())
+  {
+    error = "No input files.";
+    return false;
+  }
+
+  qint64 totalSize = 0;
+  for(const auto &input: inputs)
+  {
+    if(QFileInfo(input).absoluteFilePath() == QFileInfo(output).absoluteFilePath())
+    {
+      error = QString("The output file '%1' is one of the inputs.").arg(output);
+      return false;
+    }
+    totalSize += QFileInfo(input).size();
+  }
+
+  AsyncFileWriter writer(output, AsyncFileWriter::Durability::NONE, totalSize);
+  if(!writer.isOpen())
+  {
+    error = QString("Unable to open file '%1'.").arg(output);
+    return false;
+  }
+  writer.start();
+
+  EbmlGlobal ebml;
+  memset(&ebml, 0, sizeof(EbmlGlobal));
+  ebml.last_pts_ms = -1;
+  ebml.writer = &writer;
+
+  // the blocks are written with their times in milliseconds.
+  vpx_codec_enc_cfg_t config;
+  memset(&config, 0, sizeof(vpx_codec_enc_cfg_t));
+  config.g_timebase.num = 1;
+  config.g_timebase.den = 1000;
+
+  std::vector<WebMReader::Track> tracks;
+  std::vector<qint64> textEnd;
+  qint64 offset = 0;
+  int hash = 0;
+  bool success = true;
+
+  // subtitles are ended when the next block is later than their end, or at the end of the file.
+  auto endTexts = [&ebml, &textEnd](const qint64 time)
+  {
+    for(unsigned int track = 1; track < textEnd.size(); ++track)
+    {
+      if(textEnd[track] != -1 && textEnd[track] < time)
+      {
+        write_webm_text(&ebml, track, textEnd[track], nullptr);
+        textEnd[track] = -1;
+      }
+    }
+  };
+
+  for(const auto &input: inputs)
+  {
+    WebMReader reader(input);
+    if(!reader.open())
+    {
+      error = QString("%1: %2").arg(input).arg(reader.error());
+      success = false;
+      break;
+    }
+
+    if(tracks.empty())
+    {
+      if(!supportedTracks(reader.tracks()))
+      {
+        error = QString("%1: the tracks are not supported.").arg(input);
+        success = false;
+        break;
+      }
+
+      tracks = reader.tracks();
+      textEnd.assign(tracks.size() + 1, -1);
+
+      for(const auto &track: tracks)
+      {
+        if(track.type == WEBM_TRACK_VIDEO)
+          webm_add_video_track(&ebml, track.width, track.height);
+        else
+          webm_add_subtitle_track(&ebml, track.name.toUtf8().constData());
+      }
+
+      config.g_w = tracks.front().width;
+      config.g_h = tracks.front().height;
+
+      // keep the cluster checksums if the recordings have them.
+      ebml.cluster_crc = !reader.clusters().empty() && reader.clusters().front().hasCrc;
+
+      struct vpx_rational framerate = {frameRate(reader), 1};
+      write_webm_file_header(&ebml, &config, &framerate);
+    }
+    else if(!sameTracks(tracks, reader.tracks()))
+    {
+      error = QString("%1: the tracks are different from the ones of '%2'.").arg(input).arg(inputs.first());
+      success = false;
+      break;
+    }
+
+    const auto end = fileEnd(reader);
+
+    // a chapter continued from the previous file (rotated files) is joined with it.
+    for(const auto &chapter: reader.chapters())
+    {
+      const auto title = chapter.title.toUtf8();
+      const auto start = offset + chapter.start;
+      const auto chapterEnd = offset + (chapter.end == -1 ? end : chapter.end);
+
+      if(ebml.chapters > 0)
+      {
+        auto last = &ebml.chapter_list[ebml.chapters - 1];
+        if(last->end == start && strncmp(last->title, title.constData(), WEBM_CHAPTER_TITLE_SIZE) == 0)
+        {
+          last->end = chapterEnd;
+          continue;
+        }
+      }
+
+      webm_add_chapter(&ebml, title.constData(), start);
+      webm_end_chapter(&ebml, chapterEnd);
+    }
+
+    // the duration of a frame lasts until the next frame of its track or the end of the file.
+    const auto &frames = reader.frames();
+    std::vector<qint64> durations(frames.size(), 0);
+    std::vector<qint64> next(tracks.size() + 1, end);
+    for(auto i = frames.size(); i-- > 0;)
+    {
+      const auto &frame = frames.at(i);
+      if(frame.track == 0 || frame.track > tracks.size()) continue;
+
+      durations[i] = frame.duration > 0 ? frame.duration : std::max<qint64>(1, next[frame.track] - frame.time);
+      next[frame.track] = frame.time;
+    }
+
+    for(unsigned long i = 0; i < frames.size(); ++i)
+    {
+      const auto &frame = frames.at(i);
+      if(frame.track == 0 || frame.track > tracks.size()) continue;
+
+      const auto time = offset + frame.time;
+      endTexts(time);
+
+      if(tracks.at(frame.track - 1).type == WEBM_TRACK_SUBTITLE)
+      {
+        // the muxer ignores the repetitions of the text in every cluster.
+        const QByteArray text(reinterpret_cast<const char *>(reader.frameData(frame)), static_cast<int>(frame.size));
+        write_webm_text(&ebml, frame.track, time, text.constData());
+        textEnd[frame.track] = time + durations[i];
+        continue;
+      }
+
+      vpx_codec_cx_pkt_t packet;
+      memset(&packet, 0, sizeof(vpx_codec_cx_pkt_t));
+      packet.kind                = VPX_CODEC_CX_FRAME_PKT;
+      packet.data.frame.buf      = const_cast<uchar *>(reader.frameData(frame));
+      packet.data.frame.sz       = frame.size;
+      packet.data.frame.pts      = time;
+      packet.data.frame.duration = static_cast<unsigned long>(durations[i]);
+      packet.data.frame.flags    = (frame.key ? VPX_FRAME_IS_KEY : 0) | (frame.invisible ? VPX_FRAME_IS_INVISIBLE : 0);
+
+      hash = murmur(packet.data.frame.buf, static_cast<int>(packet.data.frame.sz), hash);
+      write_webm_block(&ebml, &config, &packet, frame.track);
+    }
+
+    endTexts(std::numeric_limits<qint64>::max());
+
+    offset += end;
+  }
+
+  if(success)
+  {
+    ebml.end_ms = std::max<int64_t>(ebml.end_ms, offset);
+    write_webm_file_footer(&ebml, hash);
+  }
+  webm_release(&ebml);
+  writer.close();
+
+  if(!success)
+  {
+    QFile::remove(output);
+    return false;
+  }
+
+  const auto elapsed = timer.nsecsElapsed();
+  qDebug() << "Joined" << inputs.size() << "files in" << output << writer.size() << "bytes in" << elapsed / 1000000 << "ms ("
+           << (elapsed == 0 ? 0 : (writer.size() / (1024. * 1024.)) / (elapsed / 1.0e9)) << "MB/s )";
+
+  return true;
+}
+
+//------------------------------------------------------------------
+bool WebMTools::repair(const QString &fileName, QString &error)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QFile file(fileName);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    error = QString("Unable to open file: %1").arg(file.errorString());
+    return false;
+  }
+
+  const auto size = static_cast<quint64>(file.size());
+  const uchar *data = size == 0 ? nullptr : file.map(0, file.size());
+  if(!data)
+  {
+    error = QString("Unable to map file: %1").arg(file.errorString());
+    return false;
+  }
+
+  WebMReader::Element header, segment;
+  if(!WebMReader::readElement(data, 0, size, header) || header.id != EBML || header.truncated ||
+     !WebMReader::readElement(data, header.end(), size, segment) || segment.id != Segment)
+  {
+    file.unmap(const_cast<uchar *>(data));
+    error = "Not a WebM file.";
+    return false;
+  }
+
+  if(!segment.unknown && !segment.truncated)
+  {
+    file.unmap(const_cast<uchar *>(data));
+    qDebug() << fileName << "is not damaged.";
+    return true;
+  }
+
+  // the level 1 elements before the clusters are written at the start and must be complete.
+  quint64 durationPosition = 0, cuesSeekPosition = 0, cuesPosition = 0;
+  double duration = 0;
+  bool reservedEnd = false, validScale = true;
+  quint64 position = segment.dataOffset;
+  while(position < size)
+  {
+    WebMReader::Element element;
+    if(!WebMReader::readElement(data, position, size, element) || element.id == Cluster || element.unknown || element.truncated) break;
+
+    reservedEnd |= (cuesPosition != 0 && element.offset == cuesPosition + WEBM_CUES_RESERVED_SIZE);
+
+    quint64 childPosition = element.dataOffset;
+    while((element.id == SeekHead || element.id == Info) && childPosition < element.end())
+    {
+      WebMReader::Element child;
+      if(!WebMReader::readElement(data, childPosition, element.end(), child) || child.truncated) break;
+
+      if(child.id == Segment_Duration && child.size == 8)
+      {
+        durationPosition = child.offset;
+        duration = WebMReader::readFloat(data, child);
+      }
+
+      if(child.id == TimecodeScale) validScale = (WebMReader::readUnsigned(data, child) == 1000000);
+
+      // the Cues are the only seek entry that can move.
+      if(child.id == Seek)
+      {
+        quint64 id = 0, seekPosition = 0, valuePosition = 0;
+        quint64 seekChildPosition = child.dataOffset;
+        while(seekChildPosition < child.end())
+        {
+          WebMReader::Element value;
+          if(!WebMReader::readElement(data, seekChildPosition, child.end(), value) || value.truncated) break;
+
+          if(value.id == SeekID) id = WebMReader::readUnsigned(data, value);
+          if(value.id == SeekPosition && value.size == 8)
+          {
+            seekPosition  = WebMReader::readUnsigned(data, value);
+            valuePosition = value.offset;
+          }
+          seekChildPosition = value.end();
+        }
+
+        if(id == Cues && valuePosition != 0)
+        {
+          cuesSeekPosition = valuePosition;
+          cuesPosition     = segment.dataOffset + seekPosition;
+        }
+      }
+
+      childPosition = child.end();
+    }
+
+    position = element.end();
+  }
+
+  // the files recorded without the reserved Cues area, by the previous versions, get the Cues appended.
+  if(!validScale || durationPosition == 0 || cuesSeekPosition == 0 || segment.dataOffset != segment.offset + 12)
+  {
+    file.unmap(const_cast<uchar *>(data));
+    error = "The file header has no Cues seek entry or no duration, or is damaged.";
+    return false;
+  }
+
+  std::vector<RepairCluster> clusters;
+  std::vector<RepairText> texts;
+  std::vector<std::pair<quint64, quint64>> gaps;
+  quint64 dataEnd = position;
+  qint64 lastTime = -1, interval = 0;
+
+  while(position < size)
+  {
+    WebMReader::Element element;
+    quint64 timecode = 0;
+    const auto minimum = clusters.empty() ? 0 : clusters.back().timecode;
+
+    if(readClusterHeader(data, position, size, timecode) && timecode >= minimum)
+    {
+      WebMReader::readElement(data, position, size, element);
+
+      RepairCluster cluster;
+      scanCluster(data, element, static_cast<unsigned int>(clusters.size()), cluster, texts, lastTime, interval);
+      clusters.push_back(cluster);
+
+      position = dataEnd = cluster.end;
+      continue;
+    }
+
+    // damaged data, skipped up to the next cluster and voided.
+    const auto next = findCluster(data, position + 1, size, minimum);
+    if(next == 0 || next - dataEnd < 2) break;
+
+    gaps.emplace_back(dataEnd, next);
+    position = next;
+  }
+
+  file.unmap(const_cast<uchar *>(data));
+  file.close();
+
+  if(clusters.empty())
+  {
+    error = "No clusters found.";
+    return false;
+  }
+
+  // the last frame lasts as the previous one.
+  const auto end = std::max(static_cast<qint64>(duration), lastTime + std::max<qint64>(interval, 1));
+
+  AsyncFileWriter writer(fileName, AsyncFileWriter::Durability::NONE, 0, AsyncFileWriter::Mode::UPDATE);
+  if(!writer.isOpen())
+  {
+    error = QString("Unable to open file '%1' for writing.").arg(fileName);
+    return false;
+  }
+  writer.start();
+
+  EbmlGlobal ebml;
+  memset(&ebml, 0, sizeof(EbmlGlobal));
+  ebml.writer             = &writer;
+  ebml.position_reference = segment.dataOffset;
+  ebml.startSegment       = segment.offset + 4;
+  ebml.cue_pos            = reservedEnd ? cuesPosition : 0;
+  ebml.end_ms             = end;
+
+  // drop the partial trailing block and the data after it.
+  writer.resize(dataEnd);
+
+  for(const auto &gap: gaps)
+  {
+    writer.seek(gap.first);
+    Ebml_WriteVoid(&ebml, gap.second - gap.first);
+  }
+
+  unsigned int cues = 0;
+  for(const auto &cluster: clusters)
+  {
+    if(cluster.cue) ++cues;
+  }
+
+  ebml.cue_list = static_cast<struct cue_entry *>(malloc(std::max(cues, 1u) * sizeof(struct cue_entry)));
+  if(!ebml.cue_list)
+  {
+    writer.close();
+    error = "Unable to allocate the cues.";
+    return false;
+  }
+
+  for(const auto &cluster: clusters)
+  {
+    if(cluster.patch)
+    {
+      off_t sizePosition = cluster.offset + 4;
+      writer.seek(cluster.end);
+      Ebml_EndSubElement(&ebml, &sizePosition);
+    }
+
+    if(cluster.cue)
+    {
+      ebml.cue_list[ebml.cues].time = static_cast<unsigned int>(cluster.timecode);
+      ebml.cue_list[ebml.cues].loc  = cluster.offset;
+      ++ebml.cues;
+    }
+  }
+
+  // the cues open when the recording stopped end with their cluster.
+  for(const auto &text: texts)
+  {
+    if(!clusters.at(text.cluster).patch) continue;
+
+    const auto next = text.cluster + 1;
+    const auto textEnd = next < clusters.size() ? static_cast<qint64>(clusters.at(next).timecode) : end;
+
+    writer.seek(text.position);
+    Ebml_SerializeUnsigned64(&ebml, BlockDuration, static_cast<uint64_t>(std::max<qint64>(0, textEnd - text.start)));
+  }
+
+  // the checksums of the rewritten clusters are computed once their data is final.
+  for(const auto &cluster: clusters)
+  {
+    if(cluster.patch && cluster.crc != 0)
+    {
+      writer.checksum(cluster.crc + 6, cluster.end, cluster.crc + 2);
+    }
+  }
+
+  write_webm_cues(&ebml);
+  if(static_cast<quint64>(ebml.cue_pos) != cuesPosition)
+  {
+    writer.seek(cuesSeekPosition);
+    Ebml_SerializeUnsigned64(&ebml, SeekPosition, ebml.cue_pos - ebml.position_reference);
+  }
+
+  writer.seek(durationPosition);
+  Ebml_SerializeFloat(&ebml, Segment_Duration, static_cast<double>(end));
+
+  writer.seek(writer.size());
+  Ebml_EndSubElement(&ebml, &ebml.startSegment);
+
+  webm_release(&ebml);
+  writer.close();
+
+  const auto elapsed = timer.nsecsElapsed();
+  qDebug() << "Repaired" << fileName << clusters.size() << "clusters," << cues << "cues," << gaps.size() << "damaged areas,"
+           << (size - dataEnd) << "trailing bytes dropped in" << elapsed / 1000000 << "ms (" << (elapsed == 0 ? 0 : (size / (1024. * 1024.)) / (elapsed / 1.0e9)) << "MB/s )";
+
+  return true;
+}
@@ -0,0 +1,52 @@
+/*
+    File: WebMTools.h
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEBM_TOOLS_H_
+#define WEBM_TOOLS_H_
+
+// Qt
+#include <QString>
+#include <QStringList>
+
+namespace WebMTools
+{
+  /** \brief Joins the given WebM files in a new file without re-encoding. The blocks are copied
+   *  with their times rebased after the previous file, the chapters and subtitles are kept and the
+   *  Cues and SeekHead rebuilt. All the files must have the same tracks. Returns true on success.
+   * \param[in] inputs names of the files to join, in order.
+   * \param[in] output name of the file to write.
+   * \param[out] error description of the error, if any.
+   *
+   */
+  bool concatenate(const QStringList &inputs, const QString &output, QString &error);
+
+  /** \brief Repairs in place a file whose recording didn't finish. The clusters are scanned once,
+   *  resynchronizing on the cluster ids after damaged data, the partial trailing block is dropped, the
+   *  Segment and Cluster sizes and the duration are rewritten and the Cues rebuilt, in the reserved
+   *  area or appended after the last cluster for the files recorded without it. The header must have
+   *  a Cues seek entry and a duration. Only the clusters index is kept in memory. Returns true on
+   *  success, also if the file was not damaged.
+   * \param[in] fileName name of the file to repair.
+   * \param[out] error description of the error, if any.
+   *
+   */
+  bool repair(const QString &fileName, QString &error);
+}
+
+#endif // WEBM_TOOLS_H_
@@ -0,0 +1,142 @@
+/*
+    File: AsciiArtTest.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <AsciiArt.h>
+
+// Qt
+#include <QImage>
+#include <QRandomGenerator>
+#include <QtTest>
+
+// C++
+#include <vector>
+
+/** \class AsciiArtTest
+ * \brief Checks the summed-area table averages of the ASCII art cells against the per pixel sums.
+ *
+ */
+class AsciiArtTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks the averages and ramp indexes of the cells of random images, with sizes that
+     *  are not multiples of the cell size to test the ragged edges.
+     *
+     */
+    void cellAverages_data();
+    void cellAverages();
+
+  private:
+    /** \brief Returns the averages of the cells summing every pixel of every cell.
+     * \param[in] image image in RGB32 or ARGB32 format.
+     * \param[in] cell size of the cells.
+     *
+     */
+    static std::vector<unsigned int> naiveAverages(const QImage &image, const QSize &cell);
+};
+
+//------------------------------------------------------------------
+std::vector<unsigned int> AsciiArtTest::naiveAverages(const QImage &image, const QSize &cell)
+{
+  std::vector<unsigned int> averages;
+  for(int y = 0; y + cell.height() <= image.height(); y += cell.height())
+  {
+    for(int x = 0; x + cell.width() <= image.width(); x += cell.width())
+    {
+      unsigned int sum = 0;
+      for(int j = y; j < y + cell.height(); ++j)
+      {
+        for(int i = x; i < x + cell.width(); ++i)
+        {
+          sum += qGray(image.pixel(i, j));
+        }
+      }
+
+      averages.push_back(sum / (cell.width() * cell.height()));
+    }
+  }
+
+  return averages;
+}
+
+//------------------------------------------------------------------
+void AsciiArtTest::cellAverages_data()
+{
+  QTest::addColumn<int>("width");
+  QTest::addColumn<int>("height");
+  QTest::addColumn<int>("cellWidth");
+  QTest::addColumn<int>("cellHeight");
+  QTest::addColumn<int>("format");
+
+  QTest::newRow("exact cells")       << 640  << 480  << 8  << 16  << static_cast<int>(QImage::Format_RGB32);
+  QTest::newRow("ragged edges")      << 643  << 479  << 7  << 13  << static_cast<int>(QImage::Format_RGB32);
+  QTest::newRow("ragged ARGB32")     << 333  << 211  << 9  << 17  << static_cast<int>(QImage::Format_ARGB32);
+  QTest::newRow("single cell")       << 12   << 20   << 12 << 20  << static_cast<int>(QImage::Format_RGB32);
+  QTest::newRow("smaller than cell") << 5    << 30   << 6  << 10  << static_cast<int>(QImage::Format_RGB32);
+  QTest::newRow("large cells")       << 1921 << 1081 << 64 << 128 << static_cast<int>(QImage::Format_RGB32);
+}
+
+//------------------------------------------------------------------
+void AsciiArtTest::cellAverages()
+{
+  QFETCH(int, width);
+  QFETCH(int, height);
+  QFETCH(int, cellWidth);
+  QFETCH(int, cellHeight);
+  QFETCH(int, format);
+
+  QRandomGenerator generator(width * height + cellWidth);
+  const QSize cell{cellWidth, cellHeight};
+
+  for(int iteration = 0; iteration < 3; ++iteration)
+  {
+    // the last iteration has only white pixels, the largest sums.
+    QImage image(width, height, static_cast<QImage::Format>(format));
+    for(int y = 0; y < height; ++y)
+    {
+      auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+      for(int x = 0; x < width; ++x)
+      {
+        line[x] = iteration == 2 ? 0xFFFFFFFF : generator.generate();
+      }
+    }
+
+    const auto averages = AsciiArt::cellAverages(image, cell);
+    const auto expected = naiveAverages(image, cell);
+
+    QCOMPARE(averages.size(), static_cast<size_t>((width / cellWidth) * (height / cellHeight)));
+    QCOMPARE(averages, expected);
+
+    for(const int rampLength: { 2, 10, 70 })
+    {
+      for(size_t i = 0; i < averages.size(); ++i)
+      {
+        const auto index = AsciiArt::rampIndex(averages[i], rampLength);
+        QVERIFY(index < static_cast<unsigned int>(rampLength));
+        QCOMPARE(index, (expected[i] * (rampLength - 1)) / 255);
+      }
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(AsciiArtTest)
+
+#include "AsciiArtTest.moc"
@@ -0,0 +1,112 @@
+/*
+    File: BlendBenchmark.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <Blend.h>
+
+// Qt
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+
+// C++
+#include <vector>
+
+/** \class BlendBenchmark
+ * \brief Measures the blend kernels and QPainter composing a camera picture over a 1080p desktop.
+ *
+ */
+class BlendBenchmark
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void compose_data();
+    void compose();
+};
+
+//------------------------------------------------------------------
+void BlendBenchmark::compose_data()
+{
+  QTest::addColumn<int>("mode");
+  QTest::addColumn<QSize>("size");
+  QTest::addColumn<bool>("kernels");
+
+  const std::vector<std::pair<const char *, QPainter::CompositionMode>> modes = { { "SourceOver", QPainter::CompositionMode_SourceOver },
+                                                                                  { "Plus",       QPainter::CompositionMode_Plus },
+                                                                                  { "Multiply",   QPainter::CompositionMode_Multiply } };
+  const QList<QSize> sizes = { QSize{320, 240}, QSize{640, 480}, QSize{1280, 720}, QSize{1920, 1080} };
+
+  for(const auto &mode: modes)
+  {
+    for(const auto &size: sizes)
+    {
+      QTest::addRow("%s %dx%d Blend", mode.first, size.width(), size.height())    << static_cast<int>(mode.second) << size << true;
+      QTest::addRow("%s %dx%d QPainter", mode.first, size.width(), size.height()) << static_cast<int>(mode.second) << size << false;
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void BlendBenchmark::compose()
+{
+  QFETCH(int, mode);
+  QFETCH(QSize, size);
+  QFETCH(bool, kernels);
+  const auto compositionMode = static_cast<QPainter::CompositionMode>(mode);
+
+  QImage desktop(1920, 1080, QImage::Format_RGB32);
+  desktop.fill(QColor{40, 80, 120});
+
+  // semi transparent camera picture, the kernels can't take the opaque shortcuts.
+  QImage camera(size, QImage::Format_ARGB32_Premultiplied);
+  auto generator = QRandomGenerator(size.width());
+  for(int y = 0; y < camera.height(); ++y)
+  {
+    auto line = reinterpret_cast<quint32 *>(camera.scanLine(y));
+    for(int x = 0; x < camera.width(); ++x)
+    {
+      const quint32 alpha = generator.bounded(1, 255);
+      line[x] = (alpha << 24) | (generator.bounded(alpha + 1) << 16) | (generator.bounded(alpha + 1) << 8) | generator.bounded(alpha + 1);
+    }
+  }
+
+  if(kernels)
+  {
+    QBENCHMARK
+    {
+      Blend::drawImage(desktop, QPoint{0, 0}, camera, compositionMode);
+    }
+  }
+  else
+  {
+    QPainter painter(&desktop);
+    painter.setCompositionMode(compositionMode);
+
+    QBENCHMARK
+    {
+      painter.drawImage(QPoint{0, 0}, camera);
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(BlendBenchmark)
+
+#include "BlendBenchmark.moc"
@@ -0,0 +1,194 @@
+/*
+    File: BlendTest.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <Blend.h>
+
+// Qt
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+
+// C++
+#include <vector>
+
+/** \class BlendTest
+ * \brief Checks that the blend kernels give the same results as the Qt raster engine.
+ *
+ */
+class BlendTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks the dispatched SIMD kernel against the scalar reference with every row length
+     *  up to several vectors, to test the loop tails.
+     *
+     */
+    void rows_data();
+    void rows();
+
+    /** \brief Checks Blend::drawImage() against QPainter::drawImage() with the source inside and
+     *  partially outside of the destination.
+     *
+     */
+    void drawImage_data();
+    void drawImage();
+
+  private:
+    /** \brief Returns a random valid premultiplied pixel, with fully transparent and opaque
+     *  pixels more frequent than the rest.
+     * \param[in] generator random numbers generator.
+     * \param[in] opaque true to return only opaque pixels.
+     *
+     */
+    static quint32 randomPixel(QRandomGenerator &generator, const bool opaque);
+
+    /** \brief Returns an image of the given size and format with random pixels.
+     * \param[in] generator random numbers generator.
+     * \param[in] size size of the image.
+     * \param[in] format QImage::Format_RGB32 or QImage::Format_ARGB32_Premultiplied.
+     *
+     */
+    static QImage randomImage(QRandomGenerator &generator, const QSize &size, const QImage::Format format);
+};
+
+//------------------------------------------------------------------
+quint32 BlendTest::randomPixel(QRandomGenerator &generator, const bool opaque)
+{
+  quint32 alpha = generator.bounded(256);
+  if(opaque || generator.bounded(4) == 0) alpha = (opaque || generator.bounded(2)) ? 0xFF : 0;
+
+  quint32 pixel = alpha << 24;
+  for(int shift = 0; shift < 24; shift += 8)
+  {
+    pixel |= generator.bounded(alpha + 1) << shift;
+  }
+
+  return pixel;
+}
+
+//------------------------------------------------------------------
+QImage BlendTest::randomImage(QRandomGenerator &generator, const QSize &size, const QImage::Format format)
+{
+  QImage image(size, format);
+  for(int y = 0; y < image.height(); ++y)
+  {
+    auto line = reinterpret_cast<quint32 *>(image.scanLine(y));
+    for(int x = 0; x < image.width(); ++x)
+    {
+      line[x] = randomPixel(generator, format == QImage::Format_RGB32);
+    }
+  }
+
+  return image;
+}
+
+//------------------------------------------------------------------
+void BlendTest::rows_data()
+{
+  QTest::addColumn<int>("mode");
+
+  QTest::newRow("SourceOver") << static_cast<int>(QPainter::CompositionMode_SourceOver);
+  QTest::newRow("Plus")       << static_cast<int>(QPainter::CompositionMode_Plus);
+  QTest::newRow("Multiply")   << static_cast<int>(QPainter::CompositionMode_Multiply);
+}
+
+//------------------------------------------------------------------
+void BlendTest::rows()
+{
+  QFETCH(int, mode);
+  const auto compositionMode = static_cast<QPainter::CompositionMode>(mode);
+
+  QRandomGenerator generator(mode);
+  for(int length = 0; length < 70; ++length)
+  {
+    for(int iteration = 0; iteration < 100; ++iteration)
+    {
+      std::vector<quint32> source(length), destination(length);
+      for(auto &pixel: source) pixel = randomPixel(generator, false);
+      for(auto &pixel: destination) pixel = randomPixel(generator, false);
+
+      auto reference = destination;
+      Blend::blendRow(destination.data(), source.data(), length, compositionMode);
+      Blend::blendRowReference(reference.data(), source.data(), length, compositionMode);
+
+      QCOMPARE(destination, reference);
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void BlendTest::drawImage_data()
+{
+  QTest::addColumn<int>("mode");
+  QTest::addColumn<int>("format");
+
+  const std::vector<std::pair<const char *, QPainter::CompositionMode>> modes = { { "SourceOver", QPainter::CompositionMode_SourceOver },
+                                                                                  { "Plus",       QPainter::CompositionMode_Plus },
+                                                                                  { "Multiply",   QPainter::CompositionMode_Multiply } };
+
+  for(const auto &mode: modes)
+  {
+    QTest::addRow("%s ARGB32 premultiplied", mode.first) << static_cast<int>(mode.second) << static_cast<int>(QImage::Format_ARGB32_Premultiplied);
+    QTest::addRow("%s RGB32", mode.first)                << static_cast<int>(mode.second) << static_cast<int>(QImage::Format_RGB32);
+  }
+}
+
+//------------------------------------------------------------------
+void BlendTest::drawImage()
+{
+  QFETCH(int, mode);
+  QFETCH(int, format);
+  const auto compositionMode = static_cast<QPainter::CompositionMode>(mode);
+
+  QRandomGenerator generator(mode * 100 + format);
+  const auto source = randomImage(generator, QSize{97, 61}, QImage::Format_ARGB32_Premultiplied);
+
+  for(const auto &position: { QPoint{13, 7}, QPoint{200, 100}, QPoint{-20, -10} })
+  {
+    auto destination = randomImage(generator, QSize{257, 131}, static_cast<QImage::Format>(format));
+    auto expected = destination;
+
+    QVERIFY(Blend::drawImage(destination, position, source, compositionMode));
+
+    QPainter painter(&expected);
+    painter.setCompositionMode(compositionMode);
+    painter.drawImage(position, source);
+    painter.end();
+
+    for(int y = 0; y < destination.height(); ++y)
+    {
+      const auto result = reinterpret_cast<const quint32 *>(destination.constScanLine(y));
+      const auto qt = reinterpret_cast<const quint32 *>(expected.constScanLine(y));
+      for(int x = 0; x < destination.width(); ++x)
+      {
+        if(result[x] != qt[x])
+        {
+          QFAIL(qPrintable(QString("Pixel (%1,%2) is %3 instead of %4").arg(x).arg(y).arg(result[x], 8, 16, QChar('0')).arg(qt[x], 8, 16, QChar('0'))));
+        }
+      }
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(BlendTest)
+
+#include "BlendTest.moc"
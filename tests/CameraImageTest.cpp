@@ -0,0 +1,116 @@
+/*
+    File: CameraImageTest.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <CameraImage.h>
+
+// Qt
+#include <QImage>
+#include <QtTest>
+
+// OpenCV
+#include <opencv2/core/mat.hpp>
+
+/** \class CameraImageTest
+ * \brief Checks that the camera frames are wrapped without copying and with the right colors.
+ *
+ */
+class CameraImageTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks the wrap of gray and BGR frames, also of regions of larger frames whose
+     *  lines are longer than the width.
+     *
+     */
+    void wrap_data();
+    void wrap();
+
+    /** \brief Checks that the unsupported frame types give a null image.
+     *
+     */
+    void unsupported();
+};
+
+//------------------------------------------------------------------
+void CameraImageTest::wrap_data()
+{
+  QTest::addColumn<int>("type");
+  QTest::addColumn<int>("format");
+  QTest::addColumn<bool>("region");
+
+  QTest::newRow("gray")        << CV_8UC1 << static_cast<int>(QImage::Format_Grayscale8) << false;
+  QTest::newRow("gray region") << CV_8UC1 << static_cast<int>(QImage::Format_Grayscale8) << true;
+  QTest::newRow("BGR")         << CV_8UC3 << static_cast<int>(QImage::Format_BGR888)     << false;
+  QTest::newRow("BGR region")  << CV_8UC3 << static_cast<int>(QImage::Format_BGR888)     << true;
+}
+
+//------------------------------------------------------------------
+void CameraImageTest::wrap()
+{
+  QFETCH(int, type);
+  QFETCH(int, format);
+  QFETCH(bool, region);
+
+  // odd width, the lines of the frame are not aligned to 4 bytes as the ones of a QImage.
+  cv::Mat full(43, 71, type);
+  const int channels = full.channels();
+  for(int y = 0; y < full.rows; ++y)
+  {
+    auto line = full.ptr<uchar>(y);
+    for(int x = 0; x < full.cols * channels; ++x)
+    {
+      line[x] = static_cast<uchar>(x * 7 + y * 13);
+    }
+  }
+
+  const cv::Mat mat = region ? full(cv::Rect(5, 3, 37, 29)) : full;
+  const auto image = CameraImage::MatToQImage(mat);
+
+  QCOMPARE(static_cast<int>(image.format()), format);
+  QCOMPARE(image.width(), mat.cols);
+  QCOMPARE(image.height(), mat.rows);
+  QCOMPARE(static_cast<size_t>(image.bytesPerLine()), mat.step[0]);
+  QVERIFY(image.constBits() == mat.data);
+
+  const auto rgb = image.convertToFormat(QImage::Format_RGB32);
+  for(int y = 0; y < mat.rows; ++y)
+  {
+    const auto line = mat.ptr<uchar>(y);
+    for(int x = 0; x < mat.cols; ++x)
+    {
+      const auto pixel = line + x * channels;
+      const auto expected = channels == 1 ? qRgb(pixel[0], pixel[0], pixel[0]) : qRgb(pixel[2], pixel[1], pixel[0]);
+      QCOMPARE(rgb.pixel(x, y), expected);
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void CameraImageTest::unsupported()
+{
+  QVERIFY(CameraImage::MatToQImage(cv::Mat(8, 8, CV_16UC1)).isNull());
+  QVERIFY(CameraImage::MatToQImage(cv::Mat(8, 8, CV_8UC4)).isNull());
+  QVERIFY(CameraImage::MatToQImage(cv::Mat()).isNull());
+}
+
+QTEST_GUILESS_MAIN(CameraImageTest)
+
+#include "CameraImageTest.moc"
@@ -0,0 +1,140 @@
+/*
+    File: Crc32Test.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <Crc32.h>
+
+// Qt
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QtTest>
+
+// C++
+#include <vector>
+
+/** \class Crc32Test
+ * \brief Checks the slicing-by-8 CRC-32 against the known check values and the bitwise definition.
+ *
+ */
+class Crc32Test
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks the CRC-32 of the usual test strings.
+     *
+     */
+    void vectors_data();
+    void vectors();
+
+    /** \brief Checks every length up to several blocks of eight bytes at every alignment against the
+     *  bitwise CRC-32, to test the loop tails.
+     *
+     */
+    void lengths();
+
+    /** \brief Checks that the CRC-32 computed in several parts is the CRC-32 of the whole data.
+     *
+     */
+    void parts();
+
+  private:
+    /** \brief Returns the CRC-32 of the data computed bit by bit.
+     * \param[in] data raw pointer of the data.
+     * \param[in] length length of the data in bytes.
+     *
+     */
+    static quint32 bitwise(const uchar *data, const quint64 length);
+};
+
+//------------------------------------------------------------------
+quint32 Crc32Test::bitwise(const uchar *data, const quint64 length)
+{
+  quint32 crc = 0xFFFFFFFF;
+  for(quint64 i = 0; i < length; ++i)
+  {
+    crc ^= data[i];
+    for(int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+
+  return ~crc;
+}
+
+//------------------------------------------------------------------
+void Crc32Test::vectors_data()
+{
+  QTest::addColumn<QByteArray>("data");
+  QTest::addColumn<quint32>("crc");
+
+  QTest::newRow("empty")     << QByteArray{}                                              << 0x00000000u;
+  QTest::newRow("a")         << QByteArray{"a"}                                           << 0xE8B7BE43u;
+  QTest::newRow("check")     << QByteArray{"123456789"}                                   << 0xCBF43926u;
+  QTest::newRow("quick fox") << QByteArray{"The quick brown fox jumps over the lazy dog"} << 0x414FA339u;
+  QTest::newRow("zeros")     << QByteArray(32, '\0')                                      << 0x190A55ADu;
+  QTest::newRow("ones")      << QByteArray(32, '\xFF')                                    << 0xFF6CAB0Bu;
+}
+
+//------------------------------------------------------------------
+void Crc32Test::vectors()
+{
+  QFETCH(QByteArray, data);
+  QFETCH(quint32, crc);
+
+  QCOMPARE(crc32(data.constData(), data.size()), crc);
+}
+
+//------------------------------------------------------------------
+void Crc32Test::lengths()
+{
+  QRandomGenerator generator(38);
+  std::vector<uchar> data(80);
+  for(auto &value: data) value = static_cast<uchar>(generator.bounded(256));
+
+  for(int offset = 0; offset < 8; ++offset)
+  {
+    for(int length = 0; length + offset <= static_cast<int>(data.size()); ++length)
+    {
+      QCOMPARE(crc32(data.data() + offset, length), bitwise(data.data() + offset, length));
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void Crc32Test::parts()
+{
+  QRandomGenerator generator(3309);
+  std::vector<uchar> data(1000);
+  for(auto &value: data) value = static_cast<uchar>(generator.bounded(256));
+
+  const auto whole = crc32(data.data(), data.size());
+  QCOMPARE(whole, bitwise(data.data(), data.size()));
+
+  for(const quint64 split: { 0, 1, 7, 8, 13, 500, 999, 1000 })
+  {
+    const auto first = crc32(data.data(), split);
+    QCOMPARE(crc32(data.data() + split, data.size() - split, first), whole);
+  }
+}
+
+QTEST_GUILESS_MAIN(Crc32Test)
+
+#include "Crc32Test.moc"
@@ -0,0 +1,205 @@
+/*
+    File: FrameIndexTest.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <FrameIndex.h>
+
+// Qt
+#include <QRandomGenerator>
+#include <QtTest>
+
+// C++
+#include <cstring>
+#include <vector>
+
+/** \class FrameIndexTest
+ * \brief Checks the parsing and the searches of the frame index.
+ *
+ */
+class FrameIndexTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks that the header is validated and the incomplete last record ignored.
+     *
+     */
+    void records();
+
+    /** \brief Checks find() and keyFrame() against a linear search in an index with two interleaved
+     *  tracks, repeated capture times and gaps.
+     *
+     */
+    void search();
+
+    /** \brief Checks the searches before the first frame and in empty indexes.
+     *
+     */
+    void bounds();
+
+  private:
+    /** \brief Returns the index data with the given records and an extra number of bytes.
+     * \param[in] records index records.
+     * \param[in] extra number of bytes of an incomplete record after the records.
+     *
+     */
+    static std::vector<uchar> indexData(const std::vector<FrameIndex::Record> &records, const int extra);
+
+    /** \brief Returns the records of a capture of two tracks, the frames of the second track have the
+     *  capture times of some frames of the first.
+     *
+     */
+    static std::vector<FrameIndex::Record> capture();
+};
+
+//------------------------------------------------------------------
+std::vector<uchar> FrameIndexTest::indexData(const std::vector<FrameIndex::Record> &records, const int extra)
+{
+  FrameIndex::Header header;
+  ::memcpy(header.magic, FrameIndex::MAGIC, sizeof(FrameIndex::MAGIC));
+  header.version    = FrameIndex::VERSION;
+  header.recordSize = sizeof(FrameIndex::Record);
+  header.fps        = 15;
+  header.reserved   = 0;
+
+  std::vector<uchar> data(sizeof(header) + records.size() * sizeof(FrameIndex::Record) + extra, 0);
+  ::memcpy(data.data(), &header, sizeof(header));
+  if(!records.empty()) ::memcpy(data.data() + sizeof(header), records.data(), records.size() * sizeof(FrameIndex::Record));
+
+  return data;
+}
+
+//------------------------------------------------------------------
+std::vector<FrameIndex::Record> FrameIndexTest::capture()
+{
+  QRandomGenerator generator(36);
+  std::vector<FrameIndex::Record> records;
+
+  qint64 timestamp = 1000000;
+  quint64 offset = 4096;
+  for(quint32 frame = 0; frame < 500; ++frame)
+  {
+    // several frames with the same capture time and pauses of the recording.
+    timestamp += generator.bounded(4) == 0 ? 0 : 66;
+    if(generator.bounded(50) == 0) timestamp += 10000;
+
+    FrameIndex::Record record;
+    ::memset(&record, 0, sizeof(record));
+    record.timestamp = timestamp;
+    record.offset    = offset;
+    record.time      = frame * 66;
+    record.size      = 1000 + generator.bounded(1000);
+    record.track     = 1;
+    record.flags     = (frame % 30 == 0) ? FrameIndex::KEYFRAME : 0;
+    records.push_back(record);
+    offset += record.size;
+
+    if(generator.bounded(3) == 0)
+    {
+      record.offset = offset;
+      record.track  = 2;
+      record.flags  = generator.bounded(5) == 0 ? FrameIndex::KEYFRAME : 0;
+      records.push_back(record);
+      offset += record.size;
+    }
+  }
+
+  return records;
+}
+
+//------------------------------------------------------------------
+void FrameIndexTest::records()
+{
+  const auto frames = capture();
+  long long count = 0;
+
+  for(const int extra: { 0, 1, static_cast<int>(sizeof(FrameIndex::Record)) - 1 })
+  {
+    const auto data = indexData(frames, extra);
+    const auto records = FrameIndex::records(data.data(), data.size(), count);
+    QVERIFY(records != nullptr);
+    QCOMPARE(count, static_cast<long long>(frames.size()));
+    QCOMPARE(records[count - 1].offset, frames.back().offset);
+  }
+
+  auto data = indexData(frames, 0);
+  data[0] = 'X';
+  QVERIFY(FrameIndex::records(data.data(), data.size(), count) == nullptr);
+  QCOMPARE(count, 0LL);
+
+  data = indexData(frames, 0);
+  data[4] = FrameIndex::VERSION + 1;
+  QVERIFY(FrameIndex::records(data.data(), data.size(), count) == nullptr);
+
+  data = indexData(frames, 0);
+  QVERIFY(FrameIndex::records(data.data(), sizeof(FrameIndex::Header) - 1, count) == nullptr);
+  QVERIFY(FrameIndex::records(nullptr, 0, count) == nullptr);
+}
+
+//------------------------------------------------------------------
+void FrameIndexTest::search()
+{
+  const auto frames = capture();
+  const auto count = static_cast<long long>(frames.size());
+
+  for(auto timestamp = frames.front().timestamp - 100; timestamp <= frames.back().timestamp + 100; timestamp += 7)
+  {
+    for(const unsigned int track: { 1u, 2u })
+    {
+      long long expected = -1;
+      for(long long i = 0; i < count && frames[i].timestamp <= timestamp; ++i)
+      {
+        if(frames[i].track == track) expected = i;
+      }
+
+      const auto index = FrameIndex::find(frames.data(), count, timestamp, track);
+      QCOMPARE(index, expected);
+      if(index < 0) continue;
+
+      long long key = -1;
+      for(long long i = index; i >= 0 && key < 0; --i)
+      {
+        if(frames[i].track == track && (frames[i].flags & FrameIndex::KEYFRAME)) key = i;
+      }
+
+      QCOMPARE(FrameIndex::keyFrame(frames.data(), index), key);
+    }
+  }
+}
+
+//------------------------------------------------------------------
+void FrameIndexTest::bounds()
+{
+  const auto frames = capture();
+  const auto count = static_cast<long long>(frames.size());
+
+  QCOMPARE(FrameIndex::find(frames.data(), count, frames.front().timestamp - 1), -1LL);
+  QCOMPARE(FrameIndex::find(frames.data(), count, frames.front().timestamp), 0LL);
+  QCOMPARE(FrameIndex::find(frames.data(), count, frames.back().timestamp + 100000, 3), -1LL);
+  QCOMPARE(FrameIndex::find(frames.data(), 0, frames.back().timestamp), -1LL);
+  QCOMPARE(FrameIndex::find(nullptr, count, frames.back().timestamp), -1LL);
+
+  QCOMPARE(FrameIndex::keyFrame(frames.data(), 0), 0LL);
+  QCOMPARE(FrameIndex::keyFrame(frames.data(), -1), -1LL);
+  QCOMPARE(FrameIndex::keyFrame(nullptr, 0), -1LL);
+}
+
+QTEST_GUILESS_MAIN(FrameIndexTest)
+
+#include "FrameIndexTest.moc"
@@ -0,0 +1,211 @@
+/*
+    File: I420OverlayTest.cpp
+    Created on: 18/10/2026
+    Author: Felix de las Pozas Alvarez
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Project
+#include <I420Overlay.h>
+
+// Qt
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+
+// libvpx
+#include <vpx/vpx_image.h>
+
+// libyuv
+#include "libyuv/convert.h"
+
+// C++
+#include <cstdlib>
+
+/** \class I420OverlayTest
+ * \brief Checks that blending the sprites in the I420 image gives the same result, within the rounding,
+ *  as blending them in the RGB image before converting it.
+ *
+ */
+class I420OverlayTest
+: public QObject
+{
+    Q_OBJECT
+  private slots:
+    /** \brief Checks I420Overlay::blend() against QPainter SourceOver followed by libyuv::ARGBToI420()
+     *  with even and odd image sizes and sprite positions, and sprites partially outside of the image.
+     *
+     */
+    void blend_data();
+    void blend();
+
+  private:
+    /** \brief Returns a random valid premultiplied pixel, with fully transparent and opaque
+     *  pixels more frequent than the rest.
+     * \param[in] generator random numbers generator.
+     * \param[in] opaque true to return only opaque pixels.
+     *
+     */
+    static quint32 randomPixel(QRandomGenerator &generator, const bool opaque);
+
+    /** \brief Converts the RGB32 image to the I420 image of the same size.
+     * \param[in] source RGB32 image.
+     * \param[in] image I420 image.
+     *
+     */
+    static void toI420(const QImage &source, vpx_image_t &image);
+
+    /** \brief Returns the largest difference between the samples of the given plane of both images.
+     * \param[in] plane plane index.
+     * \param[in] result I420 image blended by I420Overlay.
+     * \param[in] expected I420 image converted after blending.
+     *
+     */
+    static int maximumDifference(const int plane, const vpx_image_t &result, const vpx_image_t &expected);
+};
+
+//------------------------------------------------------------------
+quint32 I420OverlayTest::randomPixel(QRandomGenerator &generator, const bool opaque)
+{
+  quint32 alpha = generator.bounded(256);
+  if(opaque || generator.bounded(4) == 0) alpha = (opaque || generator.bounded(2)) ? 0xFF : 0;
+
+  quint32 pixel = alpha << 24;
+  for(int shift = 0; shift < 24; shift += 8)
+  {
+    pixel |= generator.bounded(alpha + 1) << shift;
+  }
+
+  return pixel;
+}
+
+//------------------------------------------------------------------
+void I420OverlayTest::toI420(const QImage &source, vpx_image_t &image)
+{
+  libyuv::ARGBToI420(source.constBits(), source.bytesPerLine(),
+                     image.planes[0], image.stride[0],
+                     image.planes[1], image.stride[1],
+                     image.planes[2], image.stride[2],
+                     source.width(), source.height());
+}
+
+//------------------------------------------------------------------
+int I420OverlayTest::maximumDifference(const int plane, const vpx_image_t &result, const vpx_image_t &expected)
+{
+  const int width = plane == 0 ? result.d_w : (result.d_w + 1) / 2;
+  const int height = plane == 0 ? result.d_h : (result.d_h + 1) / 2;
+
+  int difference = 0;
+  for(int y = 0; y < height; ++y)
+  {
+    const auto resultRow = result.planes[plane] + y * result.stride[plane];
+    const auto expectedRow = expected.planes[plane] + y * expected.stride[plane];
+    for(int x = 0; x < width; ++x)
+    {
+      difference = std::max(difference, std::abs(resultRow[x] - expectedRow[x]));
+    }
+  }
+
+  return difference;
+}
+
+//------------------------------------------------------------------
+void I420OverlayTest::blend_data()
+{
+  QTest::addColumn<int>("width");
+  QTest::addColumn<int>("height");
+  QTest::addColumn<int>("x");
+  QTest::addColumn<int>("y");
+  QTest::addColumn<int>("format");
+
+  const std::vector<std::pair<const char *, QImage::Format>> formats = { { "ARGB32 premultiplied", QImage::Format_ARGB32_Premultiplied },
+                                                                         { "RGB32",                QImage::Format_RGB32 } };
+
+  for(const auto &format: formats)
+  {
+    QTest::addRow("even image, even position %s", format.first)  << 64 << 48 << 10 << 6   << static_cast<int>(format.second);
+    QTest::addRow("even image, odd position %s", format.first)   << 64 << 48 << 13 << 7   << static_cast<int>(format.second);
+    QTest::addRow("odd image, odd position %s", format.first)    << 97 << 61 << 31 << 19  << static_cast<int>(format.second);
+    QTest::addRow("top left outside %s", format.first)           << 97 << 61 << -5 << -3  << static_cast<int>(format.second);
+    QTest::addRow("bottom right outside %s", format.first)       << 97 << 61 << 85 << 50  << static_cast<int>(format.second);
+    QTest::addRow("odd image, odd edge %s", format.first)        << 33 << 25 << 11 << 9   << static_cast<int>(format.second);
+  }
+}
+
+//------------------------------------------------------------------
+void I420OverlayTest::blend()
+{
+  QFETCH(int, width);
+  QFETCH(int, height);
+  QFETCH(int, x);
+  QFETCH(int, y);
+  QFETCH(int, format);
+
+  QRandomGenerator generator(width * height + x * 100 + y + format);
+
+  // smooth desktop, the chroma of each 2x2 block is blended with the mean alpha of its pixels and
+  // differs from blending each pixel in RGB only by the variation of the desktop inside the block.
+  QImage desktop(width, height, QImage::Format_RGB32);
+  for(int j = 0; j < height; ++j)
+  {
+    auto line = reinterpret_cast<quint32 *>(desktop.scanLine(j));
+    for(int i = 0; i < width; ++i)
+    {
+      line[i] = qRgb(i * 255 / width, j * 255 / height, (i + j) * 255 / (width + height));
+    }
+  }
+
+  // odd sized sprite, partially outside of the image in some rows.
+  QImage sprite(23, 17, static_cast<QImage::Format>(format));
+  for(int j = 0; j < sprite.height(); ++j)
+  {
+    auto line = reinterpret_cast<quint32 *>(sprite.scanLine(j));
+    for(int i = 0; i < sprite.width(); ++i)
+    {
+      line[i] = randomPixel(generator, format == QImage::Format_RGB32);
+    }
+  }
+
+  vpx_image_t result, expected;
+  QVERIFY(vpx_img_alloc(&result, VPX_IMG_FMT_I420, width, height, 1));
+  QVERIFY(vpx_img_alloc(&expected, VPX_IMG_FMT_I420, width, height, 1));
+
+  toI420(desktop, result);
+  I420Overlay::blend(&result, desktop.size(), QList<I420Overlay::Sprite>{ I420Overlay::Sprite{sprite, QPoint{x, y}} });
+
+  QPainter painter(&desktop);
+  painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+  painter.drawImage(QPoint{x, y}, sprite);
+  painter.end();
+
+  toI420(desktop, expected);
+
+  // the luma is linear in RGB, the chroma also depends on the gradient inside the blocks.
+  const auto lumaDifference = maximumDifference(0, result, expected);
+  const auto uDifference = maximumDifference(1, result, expected);
+  const auto vDifference = maximumDifference(2, result, expected);
+
+  vpx_img_free(&result);
+  vpx_img_free(&expected);
+
+  QVERIFY2(lumaDifference <= 2, qPrintable(QString("Luma difference %1").arg(lumaDifference)));
+  QVERIFY2(uDifference <= 3, qPrintable(QString("U difference %1").arg(uDifference)));
+  QVERIFY2(vDifference <= 3, qPrintable(QString("V difference %1").arg(vDifference)));
+}
+
+QTEST_GUILESS_MAIN(I420OverlayTest)
+
+#include "I420OverlayTest.moc"
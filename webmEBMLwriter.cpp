@@ -20,6 +20,7 @@
 // Project
 #include <webmEBMLwriter.h>
 #include <webmIDs.h>
+#include <AsyncFileWriter.h>
 
 // C++
 #include <stdlib.h>
@@ -78,7 +79,7 @@ unsigned int murmur(const void *key, int len, unsigned int seed)
 //------------------------------------------------------------------
 void Ebml_Write(struct EbmlGlobal *global, const void *buffer_in, unsigned long len)
 {
-	(void) fwrite(buffer_in, 1, len, global->stream);
+	global->writer->write(buffer_in, len);
 }
 
 //------------------------------------------------------------------
@@ -248,12 +249,51 @@ void Ebml_SerializeString(EbmlGlobal *global, unsigned long class_id, const char
 	Ebml_WriteString(global, s);
 }
 
+//------------------------------------------------------------------
+uint64_t Ebml_WriteVoidHeader(EbmlGlobal *global, uint64_t size)
+{
+	uint64_t length;
+
+	Q_ASSERT(size >= 2);
+
+	/* Use a single byte for the size if possible. */
+	Ebml_WriteID(global, Void);
+	if (size - 2 < 0x7F)
+	{
+		length = size - 2;
+		const unsigned char sizeSerialized = 0x80 | static_cast<unsigned char>(length);
+		Ebml_Write(global, &sizeSerialized, 1);
+	}
+	else
+	{
+		length = size - 9;
+		const uint64_t sizeSerialized = length | LITERALU64(0x01000000, 0x00000000);
+		Ebml_Serialize(global, &sizeSerialized, sizeof(sizeSerialized), 8);
+	}
+
+	return length;
+}
+
+//------------------------------------------------------------------
+void Ebml_WriteVoid(EbmlGlobal *global, uint64_t size)
+{
+	static const unsigned char zeroes[4096] = {0};
+	uint64_t length = Ebml_WriteVoidHeader(global, size);
+
+	while (length > 0)
+	{
+		const unsigned long chunk = length > sizeof(zeroes) ? sizeof(zeroes) : static_cast<unsigned long>(length);
+		Ebml_Write(global, zeroes, chunk);
+		length -= chunk;
+	}
+}
+
 //------------------------------------------------------------------
 void Ebml_StartSubElement(EbmlGlobal *global, off_t *ebmlLoc, unsigned int class_id)
 {
 	const uint64_t kEbmlUnknownLength = LITERALU64(0x01FFFFFF, 0xFFFFFFFF);
 	Ebml_WriteID(global, class_id);
-	*ebmlLoc = ftello(global->stream);
+	*ebmlLoc = global->writer->position();
 	Ebml_Serialize(global, &kEbmlUnknownLength, sizeof(kEbmlUnknownLength), 8);
 }
 
@@ -264,18 +304,18 @@ void Ebml_EndSubElement(EbmlGlobal *global, off_t *ebmlLoc)
 	uint64_t size;
 
 	/* Save the current stream pointer. */
-	pos = ftello(global->stream);
+	pos = global->writer->position();
 
 	/* Calculate the size of this element. */
 	size = pos - *ebmlLoc - 8;
 	size |= LITERALU64(0x01000000, 0x00000000);
 
 	/* Seek back to the beginning of the element and write the new size. */
-	fseeko(global->stream, *ebmlLoc, SEEK_SET);
+	global->writer->seek(*ebmlLoc);
 	Ebml_Serialize(global, &size, sizeof(size), 8);
 
 	/* Reset the stream pointer. */
-	fseeko(global->stream, pos, SEEK_SET);
+	global->writer->seek(pos);
 }
 
 //------------------------------------------------------------------
@@ -295,14 +335,13 @@ void write_webm_seek_info(EbmlGlobal *global)
 	off_t pos;
 	off_t start;
 	off_t startInfo;
-	uint64_t frame_time;
 	char version_string[64];
 
 	/* Save the current stream pointer. */
-	pos = ftello(global->stream);
+	pos = global->writer->position();
 
 	if (global->seek_info_pos)
-		fseeko(global->stream, global->seek_info_pos, SEEK_SET);
+		global->writer->seek(global->seek_info_pos);
 	else
 		global->seek_info_pos = pos;
 
@@ -310,33 +349,95 @@ void write_webm_seek_info(EbmlGlobal *global)
 	write_webm_seek_element(global, Tracks, global->track_pos);
 	write_webm_seek_element(global, Cues, global->cue_pos);
 	write_webm_seek_element(global, Info, global->segment_info_pos);
+
+	/* Keep the size of the SeekHead constant, the Info follows it. */
+	if (global->chapters_written)
+		write_webm_seek_element(global, Chapters, global->chapters_pos);
+	else
+		Ebml_WriteVoid(global, WEBM_SEEK_ELEMENT_SIZE);
 	Ebml_EndSubElement(global, &start);
 
 	/* Create and write the Segment Info. */
 	strcpy(version_string, "DesktopCapture v1.0 - libVPX ");
 	strncat(version_string, vpx_codec_version_str(), sizeof(version_string) - 1 - strlen(version_string));
 
-	frame_time = (uint64_t) 1000 * global->framerate.den / global->framerate.num;
-
-	global->segment_info_pos = ftello(global->stream);
+	global->segment_info_pos = global->writer->position();
 	Ebml_StartSubElement(global, &startInfo, Info);
 	Ebml_SerializeUnsigned(global, TimecodeScale, 1000000);
-	Ebml_SerializeFloat(global, Segment_Duration, (double) (global->last_pts_ms + frame_time));
+	Ebml_SerializeFloat(global, Segment_Duration, (double) global->end_ms);
 	Ebml_SerializeString(global, MuxingApp, version_string);
 	Ebml_SerializeString(global, WritingApp, version_string);
 	Ebml_EndSubElement(global, &startInfo);
 }
 
+//------------------------------------------------------------------
+struct track_entry *webm_add_track(EbmlGlobal *global, unsigned int type, const char *name)
+{
+	struct track_entry *track;
+
+	if (global->tracks == WEBM_MAX_TRACKS)
+	{
+		qDebug("Maximum number of tracks reached.");
+		return nullptr;
+	}
+
+	track = &global->track_list[global->tracks++];
+	memset(track, 0, sizeof(struct track_entry));
+	track->type = type;
+	track->last_pts_ms = -1;
+	if (name)
+		strncpy(track->name, name, sizeof(track->name) - 1);
+
+	return track;
+}
+
+//------------------------------------------------------------------
+unsigned int webm_add_video_track(EbmlGlobal *global, unsigned int width, unsigned int height)
+{
+	struct track_entry *track = webm_add_track(global, WEBM_TRACK_VIDEO, nullptr);
+
+	if (!track)
+		return 0;
+
+	track->width = width;
+	track->height = height;
+
+	return global->tracks;
+}
+
+//------------------------------------------------------------------
+unsigned int webm_add_subtitle_track(EbmlGlobal *global, const char *name)
+{
+	return webm_add_track(global, WEBM_TRACK_SUBTITLE, name) ? global->tracks : 0;
+}
+
+//------------------------------------------------------------------
+void write_webm_track_uids(EbmlGlobal *global, int hash)
+{
+	unsigned int i;
+
+	/* The first track keeps the hash, the others derive it from their number. */
+	for (i = 0; i < global->tracks; i++)
+	{
+		const unsigned int number = i + 1;
+		const unsigned int uid = (i == 0) ? static_cast<unsigned int>(hash) : murmur(&number, sizeof(number), hash);
+
+		global->writer->seek(global->track_list[i].uid_pos);
+		Ebml_SerializeUnsigned32(global, TrackUID, uid);
+	}
+}
+
 //------------------------------------------------------------------
 void write_webm_file_header(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const struct vpx_rational *fps)
 {
 	off_t start;
 	off_t trackStart;
 	off_t videoStart;
-	unsigned int trackNumber = 1;
+	unsigned int i;
 	uint64_t trackID = 0;
-	unsigned int pixelWidth = cfg->g_w;
-	unsigned int pixelHeight = cfg->g_h;
+
+	if (global->tracks == 0)
+		webm_add_video_track(global, cfg->g_w, cfg->g_h);
 
 	/* Write the EBML header. */
 	Ebml_StartSubElement(global, &start, EBML);
@@ -351,104 +452,286 @@ void write_webm_file_header(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg,
 
 	/* Open and begin writing the segment element. */
 	Ebml_StartSubElement(global, &global->startSegment, Segment);
-	global->position_reference = ftello(global->stream);
+	global->position_reference = global->writer->position();
 	global->framerate = *fps;
 	write_webm_seek_info(global);
 
 	/* Open and write the Tracks element. */
-	global->track_pos = ftello(global->stream);
+	global->track_pos = global->writer->position();
 	Ebml_StartSubElement(global, &trackStart, Tracks);
 
-	/* Open and write the Track entry. */
-	Ebml_StartSubElement(global, &start, TrackEntry);
-	Ebml_SerializeUnsigned(global, TrackNumber, trackNumber);
-	global->track_id_pos = ftello(global->stream);
-	Ebml_SerializeUnsigned32(global, TrackUID, trackID);
-	Ebml_SerializeUnsigned(global, TrackType, 1);
-	Ebml_SerializeString(global, CodecID, "V_VP8");
-	Ebml_StartSubElement(global, &videoStart, Video);
-	Ebml_SerializeUnsigned(global, PixelWidth, pixelWidth);
-	Ebml_SerializeUnsigned(global, PixelHeight, pixelHeight);
-	Ebml_SerializeUnsigned(global, StereoMode, STEREO_FORMAT_MONO);
-	Ebml_EndSubElement(global, &videoStart);
-
-	/* Close Track entry. */
-	Ebml_EndSubElement(global, &start);
+	for (i = 0; i < global->tracks; i++)
+	{
+		struct track_entry *track = &global->track_list[i];
+
+		/* Open and write the Track entry. */
+		Ebml_StartSubElement(global, &start, TrackEntry);
+		Ebml_SerializeUnsigned(global, TrackNumber, i + 1);
+		track->uid_pos = global->writer->position();
+		Ebml_SerializeUnsigned32(global, TrackUID, trackID);
+		Ebml_SerializeUnsigned(global, TrackType, track->type);
+		if (track->name[0] != '\0')
+			Ebml_SerializeString(global, Name, track->name);
+
+		if (track->type == WEBM_TRACK_SUBTITLE)
+			Ebml_SerializeString(global, CodecID, "D_WEBVTT/SUBTITLES");
+		else
+		{
+			Ebml_SerializeString(global, CodecID, "V_VP8");
+			Ebml_StartSubElement(global, &videoStart, Video);
+			Ebml_SerializeUnsigned(global, PixelWidth, track->width);
+			Ebml_SerializeUnsigned(global, PixelHeight, track->height);
+			Ebml_SerializeUnsigned(global, StereoMode, STEREO_FORMAT_MONO);
+			Ebml_EndSubElement(global, &videoStart);
+		}
+
+		/* Close Track entry. */
+		Ebml_EndSubElement(global, &start);
+	}
 
 	/* Close Tracks element. */
 	Ebml_EndSubElement(global, &trackStart);
 
+	/* Reserve space for the Cues, filled on checkpoints and when the file is finished. */
+	global->cue_pos = global->writer->position();
+	Ebml_WriteVoid(global, WEBM_CUES_RESERVED_SIZE);
+
+	/* Reserve space for the Chapters. */
+	global->chapters_pos = global->writer->position();
+	Ebml_WriteVoid(global, WEBM_CHAPTERS_RESERVED_SIZE);
+
 	/* Segment element remains open. */
 }
 
 //------------------------------------------------------------------
-void write_webm_block(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const vpx_codec_cx_pkt_t *pkt)
+void write_webm_text_duration(EbmlGlobal *global, struct track_entry *track, int64_t end_ms)
 {
+	const off_t pos = global->writer->position();
+	const uint64_t duration = (end_ms > track->text_start) ? end_ms - track->text_start : 0;
+
+	global->writer->seek(track->text_duration_pos);
+	Ebml_SerializeUnsigned64(global, BlockDuration, duration);
+	global->writer->seek(pos);
+
+	track->text_duration_pos = 0;
+}
+
+//------------------------------------------------------------------
+void write_webm_text_block(EbmlGlobal *global, unsigned int track_number, int64_t time_ms)
+{
+	struct track_entry *track = &global->track_list[track_number - 1];
+	const unsigned long length = static_cast<unsigned long>(strlen(track->text));
+	const int16_t block_timecode = static_cast<int16_t>(time_ms - global->cluster_timecode);
+	const unsigned char track_id = static_cast<unsigned char>(track_number) | 0x80;
+	const unsigned char flags = 0;
 	unsigned int block_length;
-	unsigned char track_number;
-	uint16_t block_timecode = 0;
+	off_t start;
+
+	Ebml_StartSubElement(global, &start, BlockGroup);
+
+	Ebml_WriteID(global, Block);
+	block_length = (length + 4) | 0x10000000;
+	Ebml_Serialize(global, &block_length, sizeof(block_length), 4);
+	Ebml_Write(global, &track_id, 1);
+	Ebml_Serialize(global, &block_timecode, sizeof(block_timecode), 2);
+	Ebml_Write(global, &flags, 1);
+	Ebml_Write(global, track->text, length);
+
+	/* Fixed size duration, patched when the cue ends. */
+	track->text_start = time_ms;
+	track->text_duration_pos = global->writer->position();
+	Ebml_SerializeUnsigned64(global, BlockDuration, 0);
+
+	Ebml_EndSubElement(global, &start);
+}
+
+//------------------------------------------------------------------
+void write_webm_pending_texts(EbmlGlobal *global)
+{
+	unsigned int i;
+
+	for (i = 0; i < global->tracks; i++)
+	{
+		if (global->track_list[i].text != nullptr && global->track_list[i].text_duration_pos == 0)
+			write_webm_text_block(global, i + 1, global->cluster_timecode);
+	}
+}
+
+//------------------------------------------------------------------
+void webm_close_cluster(EbmlGlobal *global, int64_t end_ms)
+{
+	unsigned int i;
+
+	if (!global->cluster_open)
+		return;
+
+	/* The open cues end with the cluster and continue in the next one. */
+	write_webm_pending_texts(global);
+	for (i = 0; i < global->tracks; i++)
+	{
+		if (global->track_list[i].text_duration_pos != 0)
+			write_webm_text_duration(global, &global->track_list[i], end_ms);
+	}
+
+	Ebml_EndSubElement(global, &global->startCluster);
+	global->cluster_open = 0;
+
+	/* The checksum covers the elements after the CRC-32, the writer thread reads them back. */
+	if (global->cluster_crc)
+		global->writer->checksum(global->cluster_crc_pos + 6, global->writer->position(), global->cluster_crc_pos + 2);
+
+	global->writer->syncPoint();
+}
+
+//------------------------------------------------------------------
+void webm_open_cluster(EbmlGlobal *global, int64_t pts_ms, int add_cue)
+{
+	global->cluster_open = 1;
+	global->cluster_timecode = static_cast<uint32_t>(pts_ms);
+	global->cluster_pos = global->writer->position();
+	Ebml_StartSubElement(global, &global->startCluster, Cluster);
+
+	/* The CRC-32 must be the first element of the cluster, its value is written on close. */
+	if (global->cluster_crc)
+	{
+		static const unsigned char crc[4] = {0};
+
+		global->cluster_crc_pos = global->writer->position();
+		Ebml_WriteID(global, CRC_32);
+		Ebml_WriteLen(global, sizeof(crc));
+		Ebml_Write(global, crc, sizeof(crc));
+	}
+
+	Ebml_SerializeUnsigned(global, Timecode, global->cluster_timecode);
+
+	/* Save a cue point if this is a keyframe. */
+	if (add_cue)
+	{
+		struct cue_entry *cue, *new_cue_list;
+
+		new_cue_list = static_cast<struct cue_entry *>(realloc(global->cue_list, (global->cues + 1) * sizeof(struct cue_entry)));
+		if (new_cue_list)
+			global->cue_list = new_cue_list;
+		else
+		{
+			qDebug("Failed to realloc cue list.");
+			Q_ASSERT(false);
+		}
+		cue = &global->cue_list[global->cues];
+		cue->time = global->cluster_timecode;
+		cue->loc = global->cluster_pos;
+		global->cues++;
+	}
+
+	/* The texts of the subtitle tracks are repeated in the new cluster when a later block is written,
+	 * a text that changes at the cluster time doesn't leave an empty cue. */
+}
+
+//------------------------------------------------------------------
+void write_webm_text(EbmlGlobal *global, unsigned int track_number, int64_t time_ms, const char *text)
+{
+	struct track_entry *track;
+
+	Q_ASSERT(track_number >= 1 && track_number <= global->tracks);
+	track = &global->track_list[track_number - 1];
+
+	if (track->type != WEBM_TRACK_SUBTITLE)
+		return;
+
+	if (text && *text == '\0')
+		text = nullptr;
+
+	/* Only changes are written. */
+	if ((!text && !track->text) || (text && track->text && strcmp(text, track->text) == 0))
+		return;
+
+	if (time_ms < track->last_pts_ms)
+		time_ms = track->last_pts_ms;
+	if (global->cluster_open && time_ms < global->cluster_timecode)
+		time_ms = global->cluster_timecode;
+	track->last_pts_ms = time_ms;
+
+	if (global->cluster_open && time_ms > global->cluster_timecode)
+		write_webm_pending_texts(global);
+
+	if (track->text_duration_pos != 0)
+		write_webm_text_duration(global, track, time_ms);
+
+	free(track->text);
+	track->text = text ? strdup(text) : nullptr;
+
+	if (!track->text)
+		return;
+
+	if (!global->cluster_open || time_ms - global->cluster_timecode > SHRT_MAX)
+	{
+		webm_close_cluster(global, time_ms);
+		webm_open_cluster(global, time_ms, 0);
+	}
+
+	write_webm_text_block(global, track_number, time_ms);
+}
+
+//------------------------------------------------------------------
+void write_webm_block(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const vpx_codec_cx_pkt_t *pkt, unsigned int track_number)
+{
+	unsigned int block_length;
+	unsigned char track_id;
+	int16_t block_timecode = 0;
 	unsigned char flags;
-	int64_t pts_ms;
+	int64_t pts_ms, duration_ms;
 	int start_cluster = 0, is_keyframe;
+	struct track_entry *track;
+
+	Q_ASSERT(track_number >= 1 && track_number <= global->tracks);
+	track = &global->track_list[track_number - 1];
 
 	/* Calculate the PTS of this frame in milliseconds. */
 	pts_ms = pkt->data.frame.pts * 1000 * static_cast<uint64_t>(cfg->g_timebase.num) / (uint64_t) cfg->g_timebase.den;
 
-	if (pts_ms <= global->last_pts_ms)
-		pts_ms = global->last_pts_ms + 1;
+	if (pts_ms <= track->last_pts_ms)
+		pts_ms = track->last_pts_ms + 1;
+
+	track->last_pts_ms = pts_ms;
+	if (pts_ms > global->last_pts_ms)
+		global->last_pts_ms = pts_ms;
 
-	global->last_pts_ms = pts_ms;
+	/* The frames carry their real duration, use the nominal one if not set. */
+	duration_ms = pkt->data.frame.duration * 1000 * static_cast<uint64_t>(cfg->g_timebase.num) / (uint64_t) cfg->g_timebase.den;
+	if (duration_ms <= 0)
+		duration_ms = (int64_t) 1000 * global->framerate.den / global->framerate.num;
+
+	if (pts_ms + duration_ms > global->end_ms)
+		global->end_ms = pts_ms + duration_ms;
 
 	/* Calculate the relative time of this block. */
-	if (pts_ms - global->cluster_timecode > SHRT_MAX)
+	if (pts_ms - global->cluster_timecode > SHRT_MAX || pts_ms < global->cluster_timecode)
 		start_cluster = 1;
 	else
-		block_timecode = static_cast<uint16_t>(pts_ms) - global->cluster_timecode;
+		block_timecode = static_cast<int16_t>(pts_ms - global->cluster_timecode);
 
+	/* Only the keyframes of the first track start clusters and have cue points. */
 	is_keyframe = (pkt->data.frame.flags & VPX_FRAME_IS_KEY);
-	if (start_cluster || is_keyframe)
+	if (start_cluster || (is_keyframe && track_number == 1) || !global->cluster_open)
 	{
-		if (global->cluster_open)
-			Ebml_EndSubElement(global, &global->startCluster);
-
-		/* Open the new cluster. */
+		webm_close_cluster(global, pts_ms);
+		webm_open_cluster(global, pts_ms, is_keyframe && track_number == 1);
 		block_timecode = 0;
-		global->cluster_open = 1;
-		global->cluster_timecode = static_cast<uint32_t>(pts_ms);
-		global->cluster_pos = ftello(global->stream);
-		Ebml_StartSubElement(global, &global->startCluster, Cluster);
-		Ebml_SerializeUnsigned(global, Timecode, global->cluster_timecode);
-
-		/* Save a cue point if this is a keyframe. */
-		if (is_keyframe)
-		{
-			struct cue_entry *cue, *new_cue_list;
-
-			new_cue_list = static_cast<struct cue_entry *>(realloc(global->cue_list, (global->cues + 1) * sizeof(struct cue_entry)));
-			if (new_cue_list)
-				global->cue_list = new_cue_list;
-			else
-			{
-				qDebug("Failed to realloc cue list.");
-				Q_ASSERT(false);
-			}
-			cue = &global->cue_list[global->cues];
-			cue->time = global->cluster_timecode;
-			cue->loc = global->cluster_pos;
-			global->cues++;
-		}
 	}
+	else if (block_timecode > 0)
+		write_webm_pending_texts(global);
 
 	/* Write the Simple Block. */
+	global->block_pos = global->writer->position();
 	Ebml_WriteID(global, SimpleBlock);
 
 	block_length = (unsigned int) pkt->data.frame.sz + 4;
 	block_length |= 0x10000000;
 	Ebml_Serialize(global, &block_length, sizeof(block_length), 4);
 
-	track_number = 1;
-	track_number |= 0x80;
-	Ebml_Write(global, &track_number, 1);
+	track_id = static_cast<unsigned char>(track_number);
+	track_id |= 0x80;
+	Ebml_Write(global, &track_id, 1);
 
 	Ebml_Serialize(global, &block_timecode, sizeof(block_timecode), 2);
 
@@ -465,44 +748,273 @@ void write_webm_block(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const
 }
 
 //------------------------------------------------------------------
-void write_webm_file_footer(EbmlGlobal *global, int hash)
+void write_webm_cue_point(EbmlGlobal *global, const struct cue_entry *cue)
 {
-	off_t start_cues;
 	off_t start_cue_point;
 	off_t start_cue_tracks;
+
+	Ebml_StartSubElement(global, &start_cue_point, CuePoint);
+	Ebml_SerializeUnsigned(global, CueTime, cue->time);
+
+	Ebml_StartSubElement(global, &start_cue_tracks, CueTrackPositions);
+	Ebml_SerializeUnsigned(global, CueTrack, 1);
+	Ebml_SerializeUnsigned64(global, CueClusterPosition, cue->loc - global->position_reference);
+	Ebml_EndSubElement(global, &start_cue_tracks);
+
+	Ebml_EndSubElement(global, &start_cue_point);
+}
+
+//------------------------------------------------------------------
+int write_webm_reserved_cues(EbmlGlobal *global)
+{
+	const off_t reserve_end = global->cue_pos + WEBM_CUES_RESERVED_SIZE;
+
+	if (global->cues_reserve_full)
+		return 0;
+
+	if (global->cues_written == global->cues)
+		return 1;
+
+	/* Only the new entries are written, the Cues element grows over the Void that follows it. */
+	if (global->cue_write_pos == 0)
+	{
+		global->writer->seek(global->cue_pos);
+		Ebml_StartSubElement(global, &global->startCues, Cues);
+	}
+	else
+		global->writer->seek(global->cue_write_pos);
+
+	while (global->cues_written < global->cues)
+	{
+		if (reserve_end - global->writer->position() < WEBM_CUE_POINT_MAX_SIZE + 2)
+		{
+			global->cues_reserve_full = 1;
+			break;
+		}
+
+		write_webm_cue_point(global, &global->cue_list[global->cues_written]);
+		global->cues_written++;
+	}
+
+	global->cue_write_pos = global->writer->position();
+	Ebml_EndSubElement(global, &global->startCues);
+
+	/* The payload of the Void is not read, only its header moves after the new entries. */
+	if (reserve_end > global->cue_write_pos)
+		Ebml_WriteVoidHeader(global, reserve_end - global->cue_write_pos);
+
+	return !global->cues_reserve_full;
+}
+
+//------------------------------------------------------------------
+void write_webm_cues(EbmlGlobal *global)
+{
+	off_t start_cues;
 	unsigned int i;
 
-	if (global->cluster_open)
-		Ebml_EndSubElement(global, &global->startCluster);
+	/* Write the Cues at the end of the file if there is no reserved area or it is not enough. */
+	if (!global->cue_pos || !write_webm_reserved_cues(global))
+	{
+		if (global->cue_pos)
+		{
+			global->writer->seek(global->cue_pos);
+			Ebml_WriteVoid(global, WEBM_CUES_RESERVED_SIZE);
+		}
+		global->writer->seek(global->writer->size());
+
+		global->cue_pos = global->writer->position();
+		Ebml_StartSubElement(global, &start_cues, Cues);
 
-	global->cue_pos = ftello(global->stream);
-	Ebml_StartSubElement(global, &start_cues, Cues);
+		for (i = 0; i < global->cues; i++)
+			write_webm_cue_point(global, &global->cue_list[i]);
 
-	for (i = 0; i < global->cues; i++)
+		Ebml_EndSubElement(global, &start_cues);
+	}
+}
+
+//------------------------------------------------------------------
+void webm_add_chapter(EbmlGlobal *global, const char *title, int64_t time_ms)
+{
+	struct chapter_entry *chapter, *new_chapter_list;
+
+	webm_end_chapter(global, time_ms);
+
+	new_chapter_list = static_cast<struct chapter_entry *>(realloc(global->chapter_list, (global->chapters + 1) * sizeof(struct chapter_entry)));
+	if (!new_chapter_list)
 	{
-		struct cue_entry *cue = &global->cue_list[i];
-		Ebml_StartSubElement(global, &start_cue_point, CuePoint);
-		Ebml_SerializeUnsigned(global, CueTime, cue->time);
+		qDebug("Failed to realloc chapter list.");
+		Q_ASSERT(false);
+		return;
+	}
 
-		Ebml_StartSubElement(global, &start_cue_tracks, CueTrackPositions);
-		Ebml_SerializeUnsigned(global, CueTrack, 1);
-		Ebml_SerializeUnsigned64(global, CueClusterPosition, cue->loc - global->position_reference);
-		Ebml_EndSubElement(global, &start_cue_tracks);
+	global->chapter_list = new_chapter_list;
+	chapter = &global->chapter_list[global->chapters];
+	chapter->start = time_ms;
+	chapter->end = -1;
+	global->chapters++;
 
-		Ebml_EndSubElement(global, &start_cue_point);
+	webm_set_chapter_title(global, title);
+}
+
+//------------------------------------------------------------------
+void webm_set_chapter_title(EbmlGlobal *global, const char *title)
+{
+	struct chapter_entry *chapter;
+
+	if (global->chapters == 0)
+		return;
+
+	chapter = &global->chapter_list[global->chapters - 1];
+	strncpy(chapter->title, title, WEBM_CHAPTER_TITLE_SIZE);
+	chapter->title[WEBM_CHAPTER_TITLE_SIZE] = '\0';
+}
+
+//------------------------------------------------------------------
+void webm_end_chapter(EbmlGlobal *global, int64_t time_ms)
+{
+	struct chapter_entry *chapter;
+
+	if (global->chapters == 0)
+		return;
+
+	chapter = &global->chapter_list[global->chapters - 1];
+	if (chapter->end == -1)
+		chapter->end = (time_ms > chapter->start) ? time_ms : chapter->start;
+}
+
+//------------------------------------------------------------------
+void webm_release(EbmlGlobal *global)
+{
+	unsigned int i;
+
+	for (i = 0; i < global->tracks; i++)
+	{
+		free(global->track_list[i].text);
+		global->track_list[i].text = nullptr;
 	}
 
-	Ebml_EndSubElement(global, &start_cues);
+	free(global->cue_list);
+	global->cue_list = nullptr;
+	global->cues = 0;
+
+	free(global->chapter_list);
+	global->chapter_list = nullptr;
+	global->chapters = 0;
+}
+
+//------------------------------------------------------------------
+void write_webm_chapters(EbmlGlobal *global)
+{
+	off_t start_chapters;
+	off_t start_edition;
+	off_t start_atom;
+	off_t start_display;
+	unsigned int i;
+	int64_t end;
+
+	Ebml_StartSubElement(global, &start_chapters, Chapters);
+	Ebml_StartSubElement(global, &start_edition, EditionEntry);
+
+	for (i = 0; i < global->chapters; i++)
+	{
+		const struct chapter_entry *chapter = &global->chapter_list[i];
+
+		/* Open chapters end with the last frame. */
+		end = chapter->end;
+		if (end == -1)
+			end = global->end_ms;
+		if (end < chapter->start)
+			end = chapter->start;
+
+		Ebml_StartSubElement(global, &start_atom, ChapterAtom);
+		Ebml_SerializeUnsigned64(global, ChapterUID, i + 1);
+		Ebml_SerializeUnsigned64(global, ChapterTimeStart, static_cast<uint64_t>(chapter->start) * 1000000);
+		Ebml_SerializeUnsigned64(global, ChapterTimeEnd, static_cast<uint64_t>(end) * 1000000);
+		Ebml_StartSubElement(global, &start_display, ChapterDisplay);
+		Ebml_SerializeString(global, ChapString, chapter->title);
+		Ebml_SerializeString(global, ChapLanguage, "eng");
+		Ebml_EndSubElement(global, &start_display);
+		Ebml_EndSubElement(global, &start_atom);
+	}
+
+	Ebml_EndSubElement(global, &start_edition);
+	Ebml_EndSubElement(global, &start_chapters);
+}
+
+//------------------------------------------------------------------
+int write_webm_reserved_chapters(EbmlGlobal *global)
+{
+	const off_t reserve_end = global->chapters_pos + WEBM_CHAPTERS_RESERVED_SIZE;
+
+	if (global->chapters == 0)
+		return 1;
+
+	/* Chapters and EditionEntry headers plus the atoms and the Void of the remaining space. */
+	if (24 + static_cast<uint64_t>(global->chapters) * WEBM_CHAPTER_ATOM_MAX_SIZE + 2 > WEBM_CHAPTERS_RESERVED_SIZE)
+		return 0;
+
+	/* The whole element is rewritten, the chapter end times change. */
+	global->writer->seek(global->chapters_pos);
+	write_webm_chapters(global);
+	Ebml_WriteVoidHeader(global, reserve_end - global->writer->position());
+	global->chapters_written = 1;
+
+	return 1;
+}
+
+//------------------------------------------------------------------
+void write_webm_checkpoint(EbmlGlobal *global, int hash)
+{
+	off_t pos;
+
+	/* Close the cluster, the next block will open a new one. */
+	webm_close_cluster(global, global->end_ms);
+
+	pos = global->writer->position();
+
+	write_webm_reserved_cues(global);
+	write_webm_reserved_chapters(global);
+
+	/* Patch up the seek info block and the duration. */
+	write_webm_seek_info(global);
+
+	/* Patch up the track ids. */
+	write_webm_track_uids(global, hash);
+
+	global->writer->seek(pos);
+
+	/* Hand the data to the writer thread and sync it, without waiting for it. */
+	global->writer->sync();
+}
+
+//------------------------------------------------------------------
+void write_webm_file_footer(EbmlGlobal *global, int hash)
+{
+	webm_close_cluster(global, global->end_ms);
+
+	write_webm_cues(global);
+
+	/* Write the Chapters at the end of the file if the reserved area is not enough. */
+	if (!write_webm_reserved_chapters(global))
+	{
+		global->writer->seek(global->chapters_pos);
+		Ebml_WriteVoid(global, WEBM_CHAPTERS_RESERVED_SIZE);
+		global->writer->seek(global->writer->size());
+
+		global->chapters_pos = global->writer->position();
+		write_webm_chapters(global);
+		global->chapters_written = 1;
+	}
 
 	/* Close the Segment. */
+	global->writer->seek(global->writer->size());
 	Ebml_EndSubElement(global, &global->startSegment);
 
 	/* Patch up the seek info block. */
 	write_webm_seek_info(global);
 
-	/* Patch up the track id. */
-	fseeko(global->stream, global->track_id_pos, SEEK_SET);
-	Ebml_SerializeUnsigned32(global, TrackUID, hash);
+	/* Patch up the track ids. */
+	write_webm_track_uids(global, hash);
 
-	fseeko(global->stream, 0, SEEK_END);
+	global->writer->seek(global->writer->size());
 }
@@ -29,14 +29,42 @@
 #include "vpx/vpx_integer.h"
 #include "vpx/vpx_encoder.h"
 
+class AsyncFileWriter;
+
+/* Maximum number of tracks of a file. */
+#define WEBM_MAX_TRACKS 8
+
+/* Track types. */
+#define WEBM_TRACK_VIDEO    1
+#define WEBM_TRACK_SUBTITLE 0x11
+
+/* Maximum size of a track name. */
+#define WEBM_TRACK_NAME_SIZE 63
+
+struct track_entry
+{
+  unsigned int type;   /* track type. */
+  unsigned int width;  /* width of the video in pixels. */
+  unsigned int height; /* height of the video in pixels. */
+  char name[WEBM_TRACK_NAME_SIZE + 1]; /* name of the track, empty if none. */
+  off_t uid_pos;       /* position of the TrackUID element, patched with the hash. */
+  int64_t last_pts_ms; /* time of the last block of the track. */
+
+  /* Subtitle tracks. The cue is written when the text changes and its duration patched when it ends. */
+  char *text;          /* text of the open cue, nullptr if none. */
+  int64_t text_start;  /* start time of the open cue block in milliseconds. */
+  off_t text_duration_pos; /* position of the BlockDuration of the open cue block, 0 if not written. */
+};
+
 /** \struct EbmlGlobal
  *  \brief See http://matroska-org.github.io/libebml/ for information.
  *
  */
 struct EbmlGlobal
 {
-  FILE *stream;
+  AsyncFileWriter *writer; /* file writer, all the positions are relative to the start of the file. */
   int64_t last_pts_ms;
+  int64_t end_ms;          /* end time of the last frame in milliseconds, the duration of the segment. */
   vpx_rational_t framerate;
 
   /* These pointers are to the start of an element */
@@ -46,23 +74,58 @@ struct EbmlGlobal
   off_t track_pos;
   off_t cue_pos;
   off_t cluster_pos;
+  off_t block_pos;         /* position of the last SimpleBlock written. */
+  off_t cluster_crc_pos;   /* position of the CRC-32 element of the open cluster. */
 
-  /* This pointer is to a specific element to be serialized */
-  off_t track_id_pos;
 
   /* These pointers are to the size field of the element */
   off_t startSegment;
   off_t startCluster;
+  off_t startCues;
 
   uint32_t cluster_timecode;
   int cluster_open;
+  int cluster_crc;         /* 1 to write a CRC-32 element in every cluster. */
+
+  /* Tracks of the file, added before writing the header. Track numbers start at 1. */
+  struct track_entry track_list[WEBM_MAX_TRACKS];
+  unsigned int tracks;
 
   struct cue_entry *cue_list;
   unsigned int cues;
+
+  /* Chapters, rewritten in their reserved area on checkpoints. */
+  struct chapter_entry *chapter_list;
+  unsigned int chapters;
+  off_t chapters_pos;         /* position of the Chapters element or its reserved area. */
+  int chapters_written;       /* 1 if the Chapters element has been written. */
+
+  /* Cues reserved area, updated in place on checkpoints. */
+  off_t cue_write_pos;        /* position of the next CuePoint, 0 if the Cues haven't been started. */
+  unsigned int cues_written;  /* number of cue entries already written in the reserved area. */
+  int cues_reserve_full;      /* 1 if the reserved area can't hold more cue entries. */
 };
 
 #define LITERALU64(hi, lo) ((((uint64_t)hi) << 32) | lo)
 
+/* Size of the area reserved after the Tracks element for the Cues, in bytes. */
+#define WEBM_CUES_RESERVED_SIZE (256 * 1024)
+
+/* Maximum size of a serialized CuePoint element, in bytes. */
+#define WEBM_CUE_POINT_MAX_SIZE 37
+
+/* Size of a serialized Seek element, in bytes. */
+#define WEBM_SEEK_ELEMENT_SIZE 28
+
+/* Size of the area reserved after the Cues for the Chapters, in bytes. */
+#define WEBM_CHAPTERS_RESERVED_SIZE (32 * 1024)
+
+/* Maximum size of a chapter title in bytes, without the terminator. */
+#define WEBM_CHAPTER_TITLE_SIZE 100
+
+/* Maximum size of a serialized ChapterAtom element, in bytes. */
+#define WEBM_CHAPTER_ATOM_MAX_SIZE (57 + WEBM_CHAPTER_TITLE_SIZE)
+
 #define VP8_FOURCC (0x30385056)
 #define VP9_FOURCC (0x30395056)
 #define VP8_FOURCC_MASK (0x00385056)
@@ -84,6 +147,13 @@ struct cue_entry
   uint64_t loc;
 };
 
+struct chapter_entry
+{
+  int64_t start;                             /* start time in milliseconds. */
+  int64_t end;                               /* end time in milliseconds, -1 if the chapter is open. */
+  char title[WEBM_CHAPTER_TITLE_SIZE + 1];   /* UTF-8 title. */
+};
+
 /** \brief Murmur hash derived from public domain reference implementation at
  *   http:// sites.google.com/site/murmurhash/
  *
@@ -105,13 +175,73 @@ void Ebml_SerializeBinary(EbmlGlobal *global, unsigned long class_id, unsigned l
 void Ebml_SerializeFloat(EbmlGlobal *global, unsigned long class_id, double d);
 
 void Ebml_SerializeString(EbmlGlobal *global, unsigned long class_id, const char *s);
+uint64_t Ebml_WriteVoidHeader(EbmlGlobal *global, uint64_t size);
+void Ebml_WriteVoid(EbmlGlobal *global, uint64_t size);
 
 void Ebml_StartSubElement(EbmlGlobal *global, off_t *ebmlLoc, unsigned int class_id);
 void Ebml_EndSubElement(EbmlGlobal *global, off_t *ebmlLoc);
 
 void write_webm_seek_element(EbmlGlobal *ebml, unsigned int id, off_t pos);
+
+/** \brief Adds a video track to the file and returns its track number, 0 on error. Must be called before
+ *  writing the header. If no track is added the header adds one with the size of the configuration.
+ *
+ */
+unsigned int webm_add_video_track(EbmlGlobal *global, unsigned int width, unsigned int height);
+
 void write_webm_file_header(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const struct vpx_rational *fps);
-void write_webm_block(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const vpx_codec_cx_pkt_t *pkt);
+
+/** \brief Adds a WebVTT subtitle track to the file and returns its track number, 0 on error. Must be
+ *  called before writing the header.
+ *
+ */
+unsigned int webm_add_subtitle_track(EbmlGlobal *global, const char *name);
+
+/** \brief Sets the text of a subtitle track from the given time, empty text or nullptr ends the current cue.
+ *  Cues are split at cluster boundaries so every cluster contains the text shown in it.
+ *
+ */
+void write_webm_text(EbmlGlobal *global, unsigned int track_number, int64_t time_ms, const char *text);
+
+/** \brief Writes the packet as a block of the given track. Clusters are started by the keyframes of the
+ *  first track, the blocks of all the tracks must be written in time order.
+ *
+ */
+void write_webm_block(EbmlGlobal *global, const vpx_codec_enc_cfg_t *cfg, const vpx_codec_cx_pkt_t *pkt, unsigned int track_number = 1);
 void write_webm_file_footer(EbmlGlobal *global, int hash);
 
+/** \brief Writes all the cue entries in the area reserved for the Cues, or at the end of the file if
+ *  they don't fit or cue_pos is 0 (no reserved area). The Cues element is moved and cue_pos updated in that case.
+ *
+ */
+void write_webm_cues(EbmlGlobal *global);
+
+/** \brief Starts a chapter at the given time, the previous chapter ends at that time if open.
+ *  The title is truncated to WEBM_CHAPTER_TITLE_SIZE bytes.
+ *
+ */
+void webm_add_chapter(EbmlGlobal *global, const char *title, int64_t time_ms);
+
+/** \brief Changes the title of the last chapter.
+ *
+ */
+void webm_set_chapter_title(EbmlGlobal *global, const char *title);
+
+/** \brief Ends the last chapter at the given time if open.
+ *
+ */
+void webm_end_chapter(EbmlGlobal *global, int64_t time_ms);
+
+/** \brief Releases the memory of the cue and chapter lists.
+ *
+ */
+void webm_release(EbmlGlobal *global);
+
+/** \brief Leaves the file in a valid and seekable state without finishing it. Closes the current
+ *  cluster, updates the Cues in the reserved area and patches the duration and track id in place.
+ *  The amount of data written doesn't depend on the length of the file.
+ *
+ */
+void write_webm_checkpoint(EbmlGlobal *global, int hash);
+
 #endif // WEBM_EBML_WRITER_H_
@@ -31,6 +31,7 @@ enum wembIDs
   DocTypeVersion = 0x4287,
   DocTypeReadVersion = 0x4285,
   Void = 0xEC,
+  CRC_32 = 0xBF,
   SignatureSlot = 0x1B538667,
   SignatureAlgo = 0x7E8A,
   SignatureHash = 0x7E9A,
@@ -121,7 +122,22 @@ enum wembIDs
   CueTrackPositions = 0xB7,
   CueTrack = 0xF7,
   CueClusterPosition = 0xF1,
-  CueBlockNumber = 0x5378
+  CueBlockNumber = 0x5378,
+
+  /* Chapters */
+  Chapters = 0x1043A770,
+  EditionEntry = 0x45B9,
+  ChapterAtom = 0xB6,
+  ChapterUID = 0x73C4,
+  ChapterTimeStart = 0x91,
+  ChapterTimeEnd = 0x92,
+  ChapterDisplay = 0x80,
+  ChapString = 0x85,
+  ChapLanguage = 0x437C,
+
+  /* Other level 1 elements */
+  Tags = 0x1254C367,
+  Attachments = 0x1941A469
 };
 
 #endif // WEBMIDS_H_